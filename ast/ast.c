@@ -87,6 +87,7 @@ AstNode *init_ast_function_definition(AstNode *node) {
 AstNode *init_ast_function_call(AstNode *node) {
     node->data = (AstData) {.function_call = (FunctionCall) {
             .args = init_list(sizeof(AstNode *)),
+            .is_tail_call = 0
     }};
     return node;
 }
@@ -64,6 +64,7 @@ typedef struct {
     char *func_name; // change to some struct..?
     List *args;      // list of AST nodes.
     // type is AST nodes because arguments can be variables, literals or expressions
+    int is_tail_call; // if the call is the last thing the calling function does (set by the optimizer)
 } FunctionCall;
 
 /**
@@ -0,0 +1,15 @@
+# Writes a file into a C source file, as a null-terminated char array.
+# Usage: cmake -DINPUT=<file> -DOUTPUT=<C file> -DNAME=<array name> -P embed_file.cmake
+
+file(READ ${INPUT} content HEX)
+# 16 bytes in each line (cmake regular expressions have no {n} repetition)
+string(REPEAT "[0-9a-f][0-9a-f]" 16 line_pattern)
+string(REGEX REPLACE "(${line_pattern})" "\\1\n" content "${content}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " content "${content}")
+string(REPLACE ", \n" ",\n        " content "${content}")
+
+file(WRITE ${OUTPUT}
+        "// generated from ${INPUT} by cmake/embed_file.cmake, do not edit\n\n"
+        "const char ${NAME}[] = {\n"
+        "        ${content}0\n"
+        "};\n")
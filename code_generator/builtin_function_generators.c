@@ -1,6 +1,7 @@
 #include "builtin_function_generators.h"
 #include "../io/io.h"
 #include "instruction_generators.h"
+#include "condition_generators.h"
 #include "../expression_evaluator/expression_evaluator.h"
 #include <stdlib.h>
 #include <string.h>
@@ -17,70 +18,80 @@ void generate_print(CodeGenerator *generator, AstNode *node) {
         if (curr_arg_expr->contains_variables) {
             if (curr_arg_expr->value->type == TYPE_STRING) {
                 // string
-                char *var_name = get_var_name_formatted(((Token *) curr_arg_expr->tokens->items[0])->value);
-                char *eax = register_handler_request_register(generator->reg_handler, generator->fp, EAX);
-                char *ebx = register_handler_request_register(generator->reg_handler, generator->fp, EBX);
-                write_to_file(generator->fp, MOV, ebx, alsprintf(&buf, "[%s]", var_name));
+                char *var_name;
+                // saving the registers may move ESP, which some frames are addressed by
+                request_helper_registers(generator);
+                var_name = get_var_address(generator, ((Token *) curr_arg_expr->tokens->items[0])->value);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG, alsprintf(&buf, "[%s]", var_name));
                 free(buf);
-                write_to_file(generator->fp, MOVZX, eax, alsprintf(&buf, "byte [%s]", ebx));
+                write_to_file(generator->fp, MOVZX, HELPER_SECOND_ARG_REG,
+                              alsprintf(&buf, "byte [%s]", HELPER_FIRST_ARG_REG));
                 free(buf);
-                write_to_file(generator->fp, PUSH, EAX);
-                write_to_file(generator->fp, INC, ebx);
-                write_to_file(generator->fp, PUSH, ebx);
+                write_to_file(generator->fp, INC, HELPER_FIRST_ARG_REG);
                 write_to_file(generator->fp, CALL, PRINT_PROC);
-
-                register_handler_free_register(generator->reg_handler, generator->fp, eax);
-                register_handler_free_register(generator->reg_handler, generator->fp, ebx);
+                free_helper_registers(generator);
             } else if (strstr(
                     "andornot>=<=!=",
                     ((ArithmeticToken *) curr_arg_expr->tokens->items[curr_arg_expr->tokens->size - 1])->value.op)) {
                 // boolean
                 char *false_label = generate_label(), *end_label = generate_label();
-                generate_arithmetic_expression(generator, curr_arg_expr);
-                write_to_file(generator->fp, CMP, EXPR_RES_REG, "0");
-                write_to_file(generator->fp, JE, false_label);
-                write_to_file(generator->fp, PUSH, "4"); // push len of true
-                write_to_file(generator->fp, PUSH, TRUE_STR_VAR); // push true
-                write_to_file(generator->fp, CALL, PRINT_PROC);
+                // the helper registers are requested before the branch, so they are saved on both of its paths
+                request_helper_registers(generator);
+                generate_condition(generator, curr_arg_expr, 0, false_label);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG, TRUE_STR_VAR);
+                write_to_file(generator->fp, MOV, HELPER_SECOND_ARG_REG, "4"); // len of true
                 write_to_file(generator->fp, JMP, end_label);
                 write_to_file(generator->fp, LABEL_DEF, false_label);
-                write_to_file(generator->fp, PUSH, "5"); // push len of false
-                write_to_file(generator->fp, PUSH, FALSE_STR_VAR); // push false
-                write_to_file(generator->fp, CALL, PRINT_PROC);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG, FALSE_STR_VAR);
+                write_to_file(generator->fp, MOV, HELPER_SECOND_ARG_REG, "5"); // len of false
                 write_to_file(generator->fp, LABEL_DEF, end_label);
+                write_to_file(generator->fp, CALL, PRINT_PROC);
+                free_helper_registers(generator);
             } else if (curr_arg_expr->tokens->size == 1 &&
                        ((ArithmeticToken *) curr_arg_expr->tokens->items[0])->original_tok->type == CHAR) {
                 // char variable
-                write_to_file(generator->fp, PUSH, alsprintf(&buf, "dword '%s'",
+                request_helper_registers(generator);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG, alsprintf(&buf, "'%s'",
                                                              ((ArithmeticToken *) curr_arg_expr->tokens->items[0])->original_tok->value));
                 write_to_file(generator->fp, CALL, PRINT_CHAR_PROC);
+                free_helper_registers(generator);
                 free(buf);
             } else {
                 // int
                 generate_arithmetic_expression(generator, curr_arg_expr);
-                write_to_file(generator->fp, PUSH, EXPR_RES_REG);
+                request_helper_registers(generator);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG, EXPR_RES_REG);
                 write_to_file(generator->fp, CALL, PRINT_INT_PROC);
+                free_helper_registers(generator);
             }
         } else {
             // not containing variables
             if (curr_arg_expr->value->type == TYPE_STRING) {
-                str_sym = string_repository_lookup(generator->symbol_table->str_repo,
-                                                   curr_arg_expr->value->value.string_value);
-                write_to_file(generator->fp, PUSH, alsprintf(&buf, "%d", str_sym->length)); // buf
-                write_to_file(generator->fp, PUSH, alsprintf(&buf, "%s+1", str_sym->symbol_name)); // count
-                write_to_file(generator->fp, CALL, PRINT_PROC);
+                str_sym = get_string_symbol(generator, curr_arg_expr->value->value.string_value);
+                request_helper_registers(generator);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG,
+                              alsprintf(&buf, "%s+1", str_sym->symbol_name)); // buf
                 free(buf);
+                write_to_file(generator->fp, MOV, HELPER_SECOND_ARG_REG,
+                              alsprintf(&buf, "%d", str_sym->length)); // count
+                free(buf);
+                write_to_file(generator->fp, CALL, PRINT_PROC);
+                free_helper_registers(generator);
             } else if (curr_arg_expr->tokens->size == 1 &&
                        ((ArithmeticToken *) curr_arg_expr->tokens->items[0])->original_tok->type == CHAR) {
                 // print char
-                write_to_file(generator->fp, PUSH, alsprintf(&buf, "dword %d",
+                request_helper_registers(generator);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG, alsprintf(&buf, "%d",
                                                              (int) ((ArithmeticToken *) curr_arg_expr->tokens->items[0])->original_tok->value[0]));
                 write_to_file(generator->fp, CALL, PRINT_CHAR_PROC);
+                free_helper_registers(generator);
                 free(buf);
             } else {
-                write_to_file(generator->fp, PUSH,
+                request_helper_registers(generator);
+                write_to_file(generator->fp, MOV, HELPER_FIRST_ARG_REG,
                               alsprintf(&buf, "%d", (int) curr_arg_expr->value->value.double_value));
                 write_to_file(generator->fp, CALL, PRINT_INT_PROC);
+                free_helper_registers(generator);
                 free(buf);
             }
         }
@@ -89,7 +100,9 @@ void generate_print(CodeGenerator *generator, AstNode *node) {
 
 void generate_println(CodeGenerator *generator, AstNode *node) {
     generate_print(generator, node);
+    request_helper_registers(generator);
     write_to_file(generator->fp, CALL, PRINT_NEW_LINE_PROC);
+    free_helper_registers(generator);
 }
 
 void generate_exit(CodeGenerator *generator, AstNode *node) {
@@ -97,11 +110,12 @@ void generate_exit(CodeGenerator *generator, AstNode *node) {
     Expression *arg_expr = &((AstNode *) node->data.function_call.args->items[0])->data.expression;
     if (arg_expr->contains_variables) {
         generate_arithmetic_expression(generator, arg_expr);
-        write_to_file(generator->fp, PUSH, EXPR_RES_REG);
+        generate_push(generator, EXPR_RES_REG);
     } else {
-        write_to_file(generator->fp, PUSH, alsprintf(&buf, "%d",
-                                                     (int) (arg_expr->value->value.double_value)));
+        generate_push(generator, alsprintf(&buf, "%d", (int) (arg_expr->value->value.double_value)));
         free(buf);
     }
     write_to_file(generator->fp, CALL, EXIT_PROC);
+    // Exit doesn't return. the code after it continues with the depth before the argument was pushed
+    generator->reg_handler->stack_depth -= 4;
 }
@@ -2,11 +2,21 @@
 #include "../io/io.h"
 #include "../logging/logging.h"
 #include "instruction_generators.h"
+#include "condition_generators.h"
 #include "../config/table_initializers.h"
 #include "../expression_evaluator/expression_evaluator.h"
 #include "../config/console_colors.h"
+#include "../options_parser/options_parser.h"
+#include "../config/include_asm.h"
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+
+char *fastcall_arg_registers[FASTCALL_ARG_COUNT] = FASTCALL_ARG_REGISTERS;
+// registers a call may change, except EAX which never holds a value across statements
+char *call_clobbered_registers[] = {EBX, ECX, EDX, ESI, EDI};
+// registers a helper procedure may change, except EAX
+char *helper_clobbered_registers[] = {ECX, EDX};
 
 CodeGenerator *init_code_generator(SymbolTable *symbol_table, AstNode *root, AstNode *starting_point, char *target_path,
                                    Lexer *lexer) {
@@ -20,12 +30,20 @@ CodeGenerator *init_code_generator(SymbolTable *symbol_table, AstNode *root, Ast
     generator->reg_handler = init_register_handler();
     generator->target_path = target_path;
     generator->lexer = lexer;
+    generator->value_numbering = init_value_numbering(lexer);
+    generator->frame = NULL;
+    generator->function = NULL;
+    generator->body_label = NULL;
+    generator->tail_call_count = 0;
+    generator->conditional_move_count = 0;
+    generator->exit_label = NULL;
 
     return generator;
 }
 
 void dispose_code_generator(CodeGenerator *generator) {
     register_handler_dispose(generator->reg_handler);
+    value_numbering_dispose(generator->value_numbering);
     free(generator);
 }
 
@@ -37,33 +55,98 @@ void code_generator_generate(CodeGenerator *generator) {
     generate_data_segment(generator);
     generate_bss_segment(generator);
     generate_code_segment(generator);
+    generate_string_literals(generator);
+
+    fclose(generator->fp);
+
+    log_verbose(CODE_GENERATOR, "Common subexpression elimination: %d expression%s eliminated",
+                generator->value_numbering->eliminated_count,
+                generator->value_numbering->eliminated_count == 1 ? "" : "s");
+    log_verbose(CODE_GENERATOR, "Tail call optimization: %d call%s turned into jumps", generator->tail_call_count,
+                generator->tail_call_count == 1 ? "" : "s");
+    log_verbose(CODE_GENERATOR, "If-conversion: %d if statement%s turned into conditional moves",
+                generator->conditional_move_count, generator->conditional_move_count == 1 ? "" : "s");
+}
+
+void code_generator_generate_precomputed(CodeGenerator *generator, char *output, int output_length, int exit_code) {
+    int i;
+    char *buf;
+
+    generator->fp = fopen(generator->target_path, "w");
+    if (!generator->fp)
+        log_exception(CODE_GENERATOR, "Could not create output file at " UNDERLINE "%s", generator->target_path);
+
+    write_to_file(generator->fp, SECTION, "data");
+    for (i = 0; i < output_length; i++) {
+        if (i % PROGRAM_OUTPUT_LINE_BYTES == 0)
+            write_to_file(generator->fp, i == 0 ? "\t" PROGRAM_OUTPUT_VAR " db " : "\n\tdb ");
+        else
+            write_to_file(generator->fp, ", ");
+        write_to_file(generator->fp, "%d", (unsigned char) output[i]);
+    }
+    write_to_file(generator->fp, "\n\n");
+
+    write_to_file(generator->fp, GLOBAL, ENTRY_POINT_NAME);
+    write_to_file(generator->fp, SECTION, "text");
+    write_to_file(generator->fp, LABEL_DEF, ENTRY_POINT_NAME);
+    if (output_length > 0) {
+        // write(stdout, output, output_length)
+        write_to_file(generator->fp, MOV, EAX, "4");
+        write_to_file(generator->fp, MOV, EBX, "1");
+        write_to_file(generator->fp, MOV, ECX, PROGRAM_OUTPUT_VAR);
+        write_to_file(generator->fp, MOV, EDX, alsprintf(&buf, "%d", output_length));
+        free(buf);
+        write_to_file(generator->fp, SYSCALL_80H);
+    }
+    // exit
+    write_to_file(generator->fp, MOV, EAX, "1");
+    write_to_file(generator->fp, MOV, EBX, alsprintf(&buf, "%d", exit_code));
+    free(buf);
+    write_to_file(generator->fp, SYSCALL_80H);
 
     fclose(generator->fp);
 }
 
 void generate_data_segment(CodeGenerator *generator) {
-    List *string_symbols = generator->symbol_table->str_repo->lst;
-    StringSymbol *curr_sym;
     char zero_div_msg[] = "Program terminated because of zero division.";
-    int i, j;
+    int i;
 
     write_to_file(generator->fp, SECTION, "data");
     write_to_file(generator->fp, "\tzero_div_msg db %d, \"%s\"\n", ARRLEN(zero_div_msg) - 1, zero_div_msg);
     write_to_file(generator->fp, "\tout_buf times 11 db 0\n");
     write_to_file(generator->fp, "\tout_buf_len equ $-out_buf\n");
+    // "00", "01", ..., "99", for converting numbers to text two digits at a time
+    write_to_file(generator->fp, "\t%s db \"", DIGIT_PAIRS_VAR);
+    for (i = 0; i < 100; i++)
+        write_to_file(generator->fp, "%02d", i);
+    write_to_file(generator->fp, "\"\n");
     write_to_file(generator->fp, "\tchar_buf db 0\n");
     write_to_file(generator->fp, "\tnew_line_chr db 13\n");
     write_to_file(generator->fp, "\ttrue_str db \"true\"\n");
     write_to_file(generator->fp, "\tfalse_str db \"false\"\n");
+    // without buffering every print is written right away
+    write_to_file(generator->fp, "\t" EQU, OUTPUT_BUFFER_SIZE_NAME,
+                  compiler_options.buffered_output ? OUTPUT_BUFFER_SIZE : 0);
+    write_to_file(generator->fp, "\t%s dd 0\n", OUTPUT_BUFFER_LENGTH_VAR);
     write_to_file(generator->fp, "\n");
+}
+
+void generate_string_literals(CodeGenerator *generator) {
+    List *string_symbols = generator->symbol_table->str_repo->lst;
+    StringSymbol *curr_sym;
+    int i, j;
 
-    // define string literals
+    write_to_file(generator->fp, SECTION, "data");
     for (i = 0; i < string_symbols->size; i++) {
         curr_sym = (StringSymbol *) string_symbols->items[i];
+        // strings of functions that were not generated, or of folded prints
+        if (!curr_sym->used)
+            continue;
         write_to_file(generator->fp, "\t%s db ", curr_sym->symbol_name);
         write_to_file(generator->fp, "%d, ", curr_sym->length); // write string length
         for (j = 0; j < curr_sym->length; j++) {
-            if (strchr("\n\t", curr_sym->value[j])) { // if escape character
+            // escape characters, and quotes that would end the quoted character
+            if (!isprint((unsigned char) curr_sym->value[j]) || curr_sym->value[j] == '\'') {
                 write_to_file(generator->fp, "%d, ", curr_sym->value[j]);
             } else {
                 write_to_file(generator->fp, "'%c', ", curr_sym->value[j]);
@@ -74,38 +157,91 @@ void generate_data_segment(CodeGenerator *generator) {
     write_to_file(generator->fp, "\n");
 }
 
-void generate_bss_segment(CodeGenerator *generator) {
+int is_laid_out_before(Symbol *symbol_a, Symbol *symbol_b) {
+    VariableSymbol *var_a = &symbol_a->value.var_symbol, *var_b = &symbol_b->value.var_symbol;
+
+    // hot variables first, so they share cache lines
+    if (compiler_options.hot_data_first && var_a->loop_depth != var_b->loop_depth)
+        return var_a->loop_depth > var_b->loop_depth;
+    // dwords before bytes, so the dwords stay aligned
+    return var_a->var_size == DWORD && var_b->var_size == BYTE;
+}
+
+void insert_in_layout_order(List *layout, Symbol *symbol) {
     int i;
+
+    // stable insertion
+    list_push(layout, symbol);
+    for (i = layout->size - 1; i > 0 && is_laid_out_before(symbol, layout->items[i - 1]); i--)
+        layout->items[i] = layout->items[i - 1];
+    layout->items[i] = symbol;
+}
+
+int is_stored_variable(Symbol *symbol) {
+    switch (symbol->value.var_symbol.type) {
+        case TYPE_BOOL:
+        case TYPE_CHAR:
+        case TYPE_INT:
+        case TYPE_STRING:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void generate_bss_segment(CodeGenerator *generator) {
+    int i, offset = 0, padding = 0;
     char *var_type, *format;
     Symbol *symbol;
+    List *layout = init_list(sizeof(Symbol *));
 
     write_to_file(generator->fp, SECTION, "bss");
 
+    // only the global variables are stored here, the others are in the stack frames
     for (i = 0; i < generator->symbol_table->var_symbols->size; i++) {
         symbol = (Symbol *) generator->symbol_table->var_symbols->items[i];
+        if (symbol->value.var_symbol.global && !symbol->value.var_symbol.unused && is_stored_variable(symbol))
+            insert_in_layout_order(layout, symbol);
+    }
 
-        switch (symbol->value.var_symbol.type) {
-            case TYPE_BOOL:
-            case TYPE_CHAR:
-                var_type = RESB;
-                break;
-            case TYPE_STRING:
-            case TYPE_INT:
-                var_type = RESD;
-                break;
-            default:
-                continue;
+    for (i = 0; i < layout->size; i++) {
+        symbol = (Symbol *) layout->items[i];
+
+        if (symbol->value.var_symbol.var_size == DWORD) {
+            var_type = RESD;
+            // align dwords to 4 bytes
+            if (offset % 4 != 0) {
+                write_to_file(generator->fp, ALIGNB, 4);
+                padding += 4 - offset % 4;
+                offset += 4 - offset % 4;
+            }
+            offset += 4;
+        } else {
+            var_type = RESB;
+            offset++;
         }
         // define the variable in the data segment
         write_to_file(generator->fp, alsprintf(&format, "\t%%s%s", var_type),
                       get_var_name_formatted(symbol->value.var_symbol.var_name), 1);
         free(format);
     }
+    write_to_file(generator->fp, ALIGNB, 4);
+    write_to_file(generator->fp, "\t%s resb %s\n", OUTPUT_BUFFER_VAR, OUTPUT_BUFFER_SIZE_NAME);
     write_to_file(generator->fp, "\n");
+
+    log_verbose(CODE_GENERATOR, "Data layout: %d .bss variable%s in %d bytes (%d bytes of alignment padding)",
+                layout->size, layout->size == 1 ? "" : "s", offset, padding);
+    free(layout->items);
+    free(layout);
 }
 
 void generate_code_segment(CodeGenerator *generator) {
     char *include_asm_content;
+    if (compiler_options.align_functions > 1 || compiler_options.align_loops > 1) {
+        // pad with long NOP instructions instead of many single-byte NOPs
+        write_to_file(generator->fp, USE_PACKAGE, "smartalign");
+        write_to_file(generator->fp, ALIGN_MODE, "p6");
+    }
     write_to_file(generator->fp, GLOBAL, ENTRY_POINT_NAME);
     write_to_file(generator->fp, SECTION, "text");
     write_to_file(generator->fp, LABEL_DEF, ENTRY_POINT_NAME);
@@ -119,6 +255,7 @@ void generate_code_segment(CodeGenerator *generator) {
         write_to_file(generator->fp, XOR, EBX, EBX); // return 0
     else
         write_to_file(generator->fp, MOV, EBX, EAX); // return whatever is returned from main
+    write_to_file(generator->fp, CALL, FLUSH_OUTPUT_PROC); // keeps EBX
     write_to_file(generator->fp, MOV, EAX, "1");
     write_to_file(generator->fp, SYSCALL_80H);
     write_to_file(generator->fp, "\n");
@@ -126,8 +263,53 @@ void generate_code_segment(CodeGenerator *generator) {
     // generate functions
     generate_block(generator, generator->root->data.compound.children);
     // write helper procedures
-    write_to_file(generator->fp, include_asm_content = read_file(INCLUDE_ASM_PATH));
-    free(include_asm_content);
+    if (compiler_options.runtime_path) {
+        write_to_file(generator->fp, "%s", include_asm_content = read_file(compiler_options.runtime_path));
+        free(include_asm_content);
+    } else {
+        write_to_file(generator->fp, "%s", include_asm);
+    }
+}
+
+void generate_code_alignment(CodeGenerator *generator, int alignment) {
+    if (alignment > 1)
+        write_to_file(generator->fp, ALIGN, alignment);
+}
+
+char *get_frame_address(CodeGenerator *generator, int offset) {
+    char *address;
+
+    if (generator->frame->omits_frame_pointer)
+        return alsprintf(&address, ESP_FRAME_ADDRESS_FORMAT, generator->frame->size_name,
+                         offset + generator->reg_handler->stack_depth);
+    return alsprintf(&address, FRAME_ADDRESS_FORMAT, offset);
+}
+
+char *get_var_address(CodeGenerator *generator, char *var_name) {
+    int offset;
+
+    if (generator->frame && stack_frame_lookup(generator->frame, var_name, &offset))
+        return get_frame_address(generator, offset);
+    return get_var_name_formatted(var_name);
+}
+
+char *get_temp_address(CodeGenerator *generator, int temp_index) {
+    return get_frame_address(generator, stack_frame_get_temp_offset(generator->frame, temp_index));
+}
+
+StringSymbol *get_string_symbol(CodeGenerator *generator, char *value) {
+    StringSymbol *str_sym = string_repository_lookup(generator->symbol_table->str_repo, value);
+    str_sym->used = 1;
+    return str_sym;
+}
+
+int variable_has_storage(CodeGenerator *generator, char *var_name) {
+    int offset;
+    Symbol *symbol = symbol_table_lookup(generator->symbol_table, var_name);
+
+    if (symbol->value.var_symbol.global)
+        return !symbol->value.var_symbol.unused;
+    return generator->frame && stack_frame_lookup(generator->frame, var_name, &offset);
 }
 
 char *get_variable_size_prefix(CodeGenerator *generator, char *var_name) {
@@ -171,11 +353,19 @@ void code_generator_apply_assignment(CodeGenerator *generator, DataType var_type
 
 int generate_block(CodeGenerator *generator, List *block) {
     int i, returned = 0;
+    char *block_exit_label = generator->exit_label;
+
+    // the temporaries live in the stack frame, so code outside functions doesn't use them
+    if (generator->frame)
+        value_numbering_analyze_block(generator->value_numbering, block);
     for (i = 0; i < block->size; i++) {
+        // only the last statement leaves the block when it ends
+        generator->exit_label = i == block->size - 1 ? block_exit_label : NULL;
         generate_statement(generator, (AstNode *) block->items[i]);
         if (((AstNode *) block->items[i])->type == AST_RETURN_STATEMENT)
             returned = 1;
     }
+    generator->exit_label = block_exit_label;
     return returned;
 }
 
@@ -191,76 +381,18 @@ void generate_statement(CodeGenerator *generator, AstNode *node) {
 }
 
 void generate_complicated_arithmetic_expression(CodeGenerator *generator, List *postfix_expr_lst) {
-    int i;
-    List *stack;
-    ArithmeticToken *curr_token, *result_token, *left_token, *right_token;
-    double (*applier_func)(CodeGenerator *, char *, char *, char *, char *, int);
-    char *eax, *ebx, *format;
+    ExpressionNode *root;
+    char *eax, *ebx;
 
-    stack = init_list(sizeof(ArithmeticToken *));
+    root = expression_tree_from_postfix(postfix_expr_lst, generator->lexer);
     eax = register_handler_request_register(generator->reg_handler, generator->fp, EXPR_RES_REG);
     ebx = register_handler_request_register(generator->reg_handler, generator->fp, EBX);
 
-    for (i = 0; i < postfix_expr_lst->size; i++) {
-        curr_token = postfix_expr_lst->items[i];
-
-        if (curr_token->type == NUMBER) {
-            list_push(stack, curr_token);
-            write_to_file(generator->fp, MOV, eax, alsprintf(&format, "%d", (int) curr_token->value.number));
-            if (i != postfix_expr_lst->size - 1) // if not last element
-                write_to_file(generator->fp, PUSH, eax);
-            free(format);
-        } else if (curr_token->type == PLACEHOLDER) {
-            list_push(stack, curr_token);
-        } else if (curr_token->type == VAR) {
-            list_push(stack, curr_token);
-            if (symbol_table_lookup(generator->symbol_table, curr_token->value.var)->value.var_symbol.var_size ==
-                BYTE) {
-                write_to_file(generator->fp, MOVSX, eax,
-                              alsprintf(&format, "byte [%s]", get_var_name_formatted(curr_token->value.var)));
-            } else {
-                write_to_file(generator->fp, MOV, eax,
-                              alsprintf(&format, "[%s]", get_var_name_formatted(curr_token->value.var)));
-            }
-            if (i != postfix_expr_lst->size - 1) // if not last element
-                write_to_file(generator->fp, PUSH, eax);
-            free(format);
-        } else if (curr_token->type == OPERATOR) {
-            result_token = init_empty_arithmetic_token();
-            right_token = list_pop(stack);
-            left_token = list_pop(stack);
-            if (!right_token || !left_token) {
-                log_exception_with_trace(CODE_GENERATOR, generator->lexer, curr_token->original_tok->line,
-                                         curr_token->original_tok->column, curr_token->original_tok->length,
-                                         "Missing operands.");
-            }
-
-            applier_func = hash_table_lookup(operator_to_generator_map, curr_token->value.op);
-            if (applier_func) {
-                applier_func(generator, eax, ebx, left_token->type == PLACEHOLDER ? left_token->value.op : "",
-                             right_token->type == PLACEHOLDER ? right_token->value.op : "",
-                             i == postfix_expr_lst->size - 1);
-            } else {
-                log_exception_with_trace(CODE_GENERATOR, generator->lexer, curr_token->original_tok->line,
-                                         curr_token->original_tok->column, curr_token->original_tok->length,
-                                         "Invalid operator: %s", curr_token->value.op);
-            }
+    generate_expression_node(generator, root);
 
-            result_token->type = NUMBER;
-            result_token->value.number = 1;
-            list_push(stack, result_token);
-        }
-    }
-    list_pop(stack); // pop last element - the "result"
-    if (!list_is_empty(stack)) {
-        log_exception_with_trace(CODE_GENERATOR, generator->lexer, curr_token->original_tok->line,
-                                 curr_token->original_tok->column, curr_token->original_tok->length,
-                                 "Invalid expression");
-    }
-
-    list_dispose(stack);
     register_handler_free_register(generator->reg_handler, generator->fp, eax);
     register_handler_free_register(generator->reg_handler, generator->fp, ebx);
+    expression_tree_dispose(root);
 }
 
 // calculates complicated expressions that contains variables and stores the result in EAX
@@ -272,8 +404,8 @@ void generate_arithmetic_expression(CodeGenerator *generator, Expression *expr)
     } else {
         eax = register_handler_request_register(generator->reg_handler, generator->fp, EXPR_RES_REG);
         if (expr->value->type == TYPE_STRING) {
-            write_to_file(generator->fp, MOV, eax, string_repository_lookup(generator->symbol_table->str_repo,
-                                                                            expr->value->value.string_value)->symbol_name);
+            write_to_file(generator->fp, MOV, eax,
+                          get_string_symbol(generator, expr->value->value.string_value)->symbol_name);
         } else {
             write_to_file(generator->fp, MOV, eax,
                           alsprintf(&expr_value_str, "%d", (int) expr->value->value.double_value));
@@ -283,11 +415,172 @@ void generate_arithmetic_expression(CodeGenerator *generator, Expression *expr)
     }
 }
 
+void generate_expression_node(CodeGenerator *generator, ExpressionNode *node) {
+    char *format, *temp_name;
+    ValueNumberEntry *value_entry;
+    void (*applier_func)(CodeGenerator *, char *, char *, char *, char *, int);
+
+    switch (node->token->type) {
+        case NUMBER:
+            write_to_file(generator->fp, MOV, EXPR_RES_REG, alsprintf(&format, "%d", (int) node->token->value.number));
+            free(format);
+            break;
+        case VAR:
+            if (symbol_table_lookup(generator->symbol_table, node->token->value.var)->value.var_symbol.var_size ==
+                BYTE) {
+                write_to_file(generator->fp, MOVSX, EXPR_RES_REG,
+                              alsprintf(&format, "byte [%s]", get_var_address(generator, node->token->value.var)));
+            } else {
+                write_to_file(generator->fp, MOV, EXPR_RES_REG,
+                              alsprintf(&format, "[%s]", get_var_address(generator, node->token->value.var)));
+            }
+            free(format);
+            break;
+        case OPERATOR:
+            value_entry = value_numbering_lookup(generator->value_numbering, node);
+            if (value_entry && value_entry->action == VN_REUSE && value_entry->source->stored) {
+                // computed earlier in the basic block
+                write_to_file(generator->fp, MOV, EXPR_RES_REG,
+                              alsprintf(&format, "dword [%s]", temp_name =
+                                      get_temp_address(generator, value_entry->source->temp_index)));
+                free(format);
+                free(temp_name);
+                generator->value_numbering->eliminated_count++;
+                break;
+            }
+            if (expression_node_is_operator(node, OP_LOGICAL_AND) || expression_node_is_operator(node, OP_LOGICAL_OR)) {
+                generate_logical_expression_node(generator, node);
+                generate_value_store(generator, value_entry);
+                break;
+            }
+            // operator generators expect their operands on the stack
+            if (node->left->token->type != PLACEHOLDER) {
+                generate_expression_node(generator, node->left);
+                generate_push(generator, EXPR_RES_REG);
+            }
+            if (node->right->token->type != PLACEHOLDER) {
+                generate_expression_node(generator, node->right);
+                generate_push(generator, EXPR_RES_REG);
+            }
+            applier_func = hash_table_lookup(operator_to_generator_map, node->token->value.op);
+            if (!applier_func) {
+                log_exception_with_trace(CODE_GENERATOR, generator->lexer, node->token->original_tok->line,
+                                         node->token->original_tok->column, node->token->original_tok->length,
+                                         "Invalid operator: %s", node->token->value.op);
+            }
+            applier_func(generator, EXPR_RES_REG, EBX,
+                         node->left->token->type == PLACEHOLDER ? node->left->token->value.op : "",
+                         node->right->token->type == PLACEHOLDER ? node->right->token->value.op : "", 1);
+            generate_value_store(generator, value_entry);
+            break;
+        default:
+            break;
+    }
+}
+
+void generate_value_store(CodeGenerator *generator, ValueNumberEntry *value_entry) {
+    char *format, *temp_name;
+
+    // store only values that are used again later
+    if (!value_entry || value_entry->action != VN_SAVE || value_entry->temp_index == -1)
+        return;
+    write_to_file(generator->fp, MOV,
+                  alsprintf(&format, "dword [%s]", temp_name = get_temp_address(generator, value_entry->temp_index)),
+                  EXPR_RES_REG);
+    value_entry->stored = 1;
+    free(format);
+    free(temp_name);
+}
+
+int expression_node_is_safe_to_speculate(ExpressionNode *node) {
+    if (!node)
+        return 1;
+    // division and modulus may exit on zero division, power and factorial call procedures
+    if (expression_node_is_operator(node, OP_DIV) || expression_node_is_operator(node, OP_MOD) ||
+        expression_node_is_operator(node, OP_POW) || expression_node_is_operator(node, OP_FACT))
+        return 0;
+    return expression_node_is_safe_to_speculate(node->left) && expression_node_is_safe_to_speculate(node->right);
+}
+
+int expression_is_safe_to_speculate(Expression *expr) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables)
+        return 1;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == OPERATOR &&
+            (strcmp(token->value.op, OP_DIV) == 0 || strcmp(token->value.op, OP_MOD) == 0 ||
+             strcmp(token->value.op, OP_POW) == 0 || strcmp(token->value.op, OP_FACT) == 0))
+            return 0;
+    }
+    return 1;
+}
+
+void generate_boolean_value(CodeGenerator *generator, ExpressionNode *node) {
+    generate_expression_node(generator, node);
+    // comparisons and logical operators already result in 0/1
+    if ((node->token->type == OPERATOR && is_relational_operator(node->token->value.op)) ||
+        expression_node_is_operator(node, OP_NOT) || expression_node_is_operator(node, OP_LOGICAL_AND) ||
+        expression_node_is_operator(node, OP_LOGICAL_OR))
+        return;
+    write_to_file(generator->fp, TEST, EXPR_RES_REG, EXPR_RES_REG);
+    write_to_file(generator->fp, SETNZ, AL);
+    write_to_file(generator->fp, MOVZX, EXPR_RES_REG, AL);
+}
+
+void generate_logical_expression_node(CodeGenerator *generator, ExpressionNode *node) {
+    char *false_label, *done_label;
+
+    if (expression_node_is_safe_to_speculate(node->right)) {
+        // evaluating the right operand is harmless, so both are evaluated and combined without branches
+        generate_boolean_value(generator, node->left);
+        generate_push(generator, EXPR_RES_REG);
+        generate_boolean_value(generator, node->right);
+        generate_pop(generator, EBX);
+        write_to_file(generator->fp, expression_node_is_operator(node, OP_LOGICAL_AND) ? AND : OR, EXPR_RES_REG,
+                      EBX);
+        return;
+    }
+
+    false_label = generate_label();
+    done_label = generate_label();
+    // the right operand is evaluated only if the left one does not decide the result
+    generate_condition_node(generator, node, 0, false_label);
+    write_to_file(generator->fp, MOV, EXPR_RES_REG, "1");
+    write_to_file(generator->fp, JMP, done_label);
+    write_to_file(generator->fp, LABEL_DEF, false_label);
+    write_to_file(generator->fp, XOR, EXPR_RES_REG, EXPR_RES_REG);
+    write_to_file(generator->fp, LABEL_DEF, done_label);
+
+    free(false_label);
+    free(done_label);
+}
+
+char *get_expression_node_operand(CodeGenerator *generator, ExpressionNode *node) {
+    char *operand;
+    if (node->token->type == NUMBER)
+        return alsprintf(&operand, "%d", (int) node->token->value.number);
+    if (node->token->type == VAR &&
+        symbol_table_lookup(generator->symbol_table, node->token->value.var)->value.var_symbol.var_size == DWORD)
+        return alsprintf(&operand, "dword [%s]", get_var_address(generator, node->token->value.var));
+    return NULL;
+}
+
 void generate_variable_declaration(CodeGenerator *generator, AstNode *node) {
     char *eax, *var_name;
-    var_name = get_var_name_formatted(node->data.variable_declaration.var->name);
+    Expression *value = &node->data.variable_declaration.value->data.expression;
+
+    // a variable that is never read is not stored, but its value may still stop the program (zero division)
+    if (!variable_has_storage(generator, node->data.variable_declaration.var->name)) {
+        if (value->contains_variables)
+            generate_arithmetic_expression(generator, value);
+        return;
+    }
+    var_name = get_var_address(generator, node->data.variable_declaration.var->name);
 
-    generate_arithmetic_expression(generator, &node->data.variable_declaration.value->data.expression);
+    generate_arithmetic_expression(generator, value);
     eax = register_handler_request_register(generator->reg_handler, generator->fp, EXPR_RES_REG);
     code_generator_apply_assignment(generator, node->data.variable_declaration.var->value->type, var_name, eax);
 
@@ -297,107 +590,418 @@ void generate_variable_declaration(CodeGenerator *generator, AstNode *node) {
 void generate_assignment(CodeGenerator *generator, AstNode *node) {
     char *eax, *var_name;
     Symbol *target_var;
-    var_name = get_var_name_formatted(node->data.assignment.dst_variable->value);
+    Expression *value = &node->data.assignment.expression->data.expression;
+
+    // see generate_variable_declaration
+    if (!variable_has_storage(generator, node->data.assignment.dst_variable->value)) {
+        if (value->contains_variables)
+            generate_arithmetic_expression(generator, value);
+        return;
+    }
+    var_name = get_var_address(generator, node->data.assignment.dst_variable->value);
     target_var = (Symbol *) hash_table_lookup(generator->symbol_table->table,
                                               node->data.assignment.dst_variable->value);
 
-    generate_arithmetic_expression(generator, &node->data.assignment.expression->data.expression);
+    generate_arithmetic_expression(generator, value);
     eax = register_handler_request_register(generator->reg_handler, generator->fp, EXPR_RES_REG);
     code_generator_apply_assignment(generator, target_var->value.var_symbol.type, var_name, eax);
 
     write_to_file(generator->fp, "\n");
 }
 
+int is_leaf_function(Symbol *function) {
+    return function->value.func_symbol.callees->size == 0;
+}
+
+StackFrame *build_stack_frame(CodeGenerator *generator, AstNode *node) {
+    int i, offset;
+    char *frame_size_name, *proc_name;
+    Symbol *symbol, *function = symbol_table_lookup(generator->symbol_table, node->data.function_definition.func_name);
+    StackFrame *frame;
+    List *vars = function->value.func_symbol.vars;
+    HashTable *shared_slots = function->value.func_symbol.shared_slots;
+    List *layout;
+    int register_arg_count = get_register_arg_count(function);
+
+    // a function that references no variable needs no frame
+    if (!vars || vars->size == 0)
+        return NULL;
+
+    proc_name = get_proc_name_formatted(node->data.function_definition.func_name);
+    // ESP moves only with the pushes of the function itself in a leaf function, so it can address the frame
+    frame = init_stack_frame(alsprintf(&frame_size_name, FRAME_SIZE_FORMAT, proc_name), is_leaf_function(function));
+    free(frame_size_name);
+    free(proc_name);
+    // the stack arguments are used in place, the register arguments are stored with the local variables
+    for (i = register_arg_count; i < node->data.function_definition.args->size; i++)
+        stack_frame_add_argument(frame, ((Variable *) node->data.function_definition.args->items[i])->name,
+                                 i - register_arg_count);
+    // local variables. the variables that share the slot of another one get it after all the slots are laid out
+    layout = init_list(sizeof(Symbol *));
+    for (i = 0; i < vars->size; i++) {
+        symbol = symbol_table_lookup(generator->symbol_table, vars->items[i]);
+        if (!symbol->value.var_symbol.global && is_stored_variable(symbol) &&
+            !stack_frame_lookup(frame, vars->items[i], &offset) && !hash_table_lookup(shared_slots, vars->items[i]))
+            insert_in_layout_order(layout, symbol);
+    }
+    for (i = 0; i < layout->size; i++) {
+        symbol = layout->items[i];
+        stack_frame_add_local(frame, symbol->value.var_symbol.var_name, symbol->value.var_symbol.var_size);
+    }
+    for (i = 0; i < vars->size; i++) {
+        if (hash_table_lookup(shared_slots, vars->items[i]))
+            stack_frame_add_shared_local(frame, vars->items[i], hash_table_lookup(shared_slots, vars->items[i]));
+    }
+    free(layout->items);
+    free(layout);
+
+    return frame;
+}
+
+int get_register_arg_count(Symbol *function) {
+    if (!function->value.func_symbol.fastcall)
+        return 0;
+    return MIN(function->value.func_symbol.arg_types->size, FASTCALL_ARG_COUNT);
+}
+
+void generate_function_epilogue(CodeGenerator *generator) {
+    char *frame_size;
+    int stack_arg_count = generator->function->value.func_symbol.arg_types->size -
+                          get_register_arg_count(generator->function);
+
+    if (generator->frame && generator->frame->omits_frame_pointer) {
+        // release the frame, and whatever is still pushed (like the registers saved by the loops around)
+        if (generator->reg_handler->stack_depth == 0) {
+            write_to_file(generator->fp, ADD, ESP, generator->frame->size_name);
+        } else {
+            alsprintf(&frame_size, "%s+%d", generator->frame->size_name, generator->reg_handler->stack_depth);
+            write_to_file(generator->fp, ADD, ESP, frame_size);
+            free(frame_size);
+        }
+    } else if (generator->frame) {
+        write_to_file(generator->fp, LEAVE);
+    }
+    if (stack_arg_count == 0) {
+        // no args
+        write_to_file(generator->fp, RET);
+    } else {
+        write_to_file(generator->fp, RET_NUM, stack_arg_count * 4);
+    }
+}
+
 void generate_function(CodeGenerator *generator, AstNode *node) {
-    int returned, i;
-    char *proc_name = get_proc_name_formatted(node->data.function_definition.func_name), *arg_buf;
-    char *eax;
-    Variable *curr_arg;
+    int returned, i, offset;
+    char *proc_name = get_proc_name_formatted(node->data.function_definition.func_name);
+    char *reg, *var_address;
+    Variable *arg;
+
+    // functions that can't be called from the starting point are not generated
+    generator->function = symbol_table_lookup(generator->symbol_table, node->data.function_definition.func_name);
+    if (!generator->function->value.func_symbol.reachable) {
+        free(proc_name);
+        return;
+    }
 
     // function name label
     write_to_file(generator->fp, GLOBAL, proc_name);
+    generate_code_alignment(generator, compiler_options.align_functions);
     write_to_file(generator->fp, LABEL_DEF, proc_name);
-    // if function accepts arguments, use EBP
-    if (node->data.function_definition.args->size > 0) {
-        write_to_file(generator->fp, PUSH, EBP);
-        write_to_file(generator->fp, MOV, EBP, ESP);
-        eax = register_handler_request_register(generator->reg_handler, generator->fp, EAX);
-        // initialize arguments
-        for (i = 0; i < node->data.function_definition.args->size; i++) {
-            curr_arg = (Variable *) node->data.function_definition.args->items[i];
-            write_to_file(generator->fp, MOV, eax, alsprintf(&arg_buf, "[ebp+%d]", 8 + 4 * i));
-            free(arg_buf);
-            if (symbol_table_lookup(generator->symbol_table, curr_arg->name)->value.var_symbol.var_size == BYTE) {
-                // byte
-                write_to_file(generator->fp, MOV,
-                              alsprintf(&arg_buf, "byte [%s]", get_var_name_formatted(curr_arg->name)),
-                              AL);
-            } else {
-                // dword
-                write_to_file(generator->fp, MOV,
-                              alsprintf(&arg_buf, "dword [%s]", get_var_name_formatted(curr_arg->name)),
-                              eax);
-            }
+    // set up the stack frame. its size is known after the body is generated (the temporaries are counted then)
+    generator->frame = build_stack_frame(generator, node);
+    generator->reg_handler->stack_depth = 0;
+    if (generator->frame) {
+        if (!generator->frame->omits_frame_pointer) {
+            write_to_file(generator->fp, PUSH, EBP);
+            write_to_file(generator->fp, MOV, EBP, ESP);
+        }
+        write_to_file(generator->fp, SUB, ESP, generator->frame->size_name);
+        // store the register arguments that are used
+        for (i = 0; i < get_register_arg_count(generator->function); i++) {
+            arg = node->data.function_definition.args->items[i];
+            if (!stack_frame_lookup(generator->frame, arg->name, &offset))
+                continue;
+            reg = register_handler_request_register(generator->reg_handler, generator->fp, fastcall_arg_registers[i]);
+            code_generator_apply_assignment(generator, arg->value->type,
+                                            var_address = get_var_address(generator, arg->name), reg);
+            free(var_address);
         }
-        register_handler_free_register(generator->reg_handler, generator->fp, eax);
         write_to_file(generator->fp, "\n");
     }
+    // self tail calls jump here
+    if (list_contains(generator->function->value.func_symbol.callees, generator->function)) {
+        generator->body_label = generate_label();
+        write_to_file(generator->fp, LABEL_DEF, generator->body_label);
+    }
+    generator->value_numbering->max_temp_count = 0;
     // generate body
+    generator->exit_label = NULL;
     returned = generate_block(generator, node->data.function_definition.body);
 
     // return manually if there is no return statement
-    if (!returned) {
-        if (node->data.function_definition.args->size == 0) {
-            // no args
-            write_to_file(generator->fp, RET);
-        } else {
-            write_to_file(generator->fp, POP, EBP);
-            write_to_file(generator->fp, RET_NUM, node->data.function_definition.args->size * 4);
-        }
-    }
+    if (!returned)
+        generate_function_epilogue(generator);
     write_to_file(generator->fp, COMMENT, proc_name);
 
+    if (generator->frame) {
+        generator->frame->temp_count = generator->value_numbering->max_temp_count;
+        write_to_file(generator->fp, EQU, generator->frame->size_name, stack_frame_get_size(generator->frame));
+        stack_frame_dispose(generator->frame);
+        generator->frame = NULL;
+    }
+    generator->function = NULL;
+    free(generator->body_label);
+    generator->body_label = NULL;
+
     write_to_file(generator->fp, "\n");
     free(proc_name);
 }
 
-void generate_function_call(CodeGenerator *generator, AstNode *node) {
+void request_helper_registers(CodeGenerator *generator) {
     int i;
+
+    for (i = 0; i < ARRLEN(helper_clobbered_registers); i++)
+        register_handler_request_register(generator->reg_handler, generator->fp, helper_clobbered_registers[i]);
+}
+
+void free_helper_registers(CodeGenerator *generator) {
+    int i;
+
+    for (i = ARRLEN(helper_clobbered_registers) - 1; i >= 0; i--)
+        register_handler_free_register(generator->reg_handler, generator->fp, helper_clobbered_registers[i]);
+}
+
+int can_generate_tail_call(CodeGenerator *generator, Symbol *function) {
+    int i;
+
+    if (function == generator->function)
+        return 1;
+    // the callee pops the arguments of the current function
+    if (function->value.func_symbol.arg_types->size - get_register_arg_count(function) !=
+        generator->function->value.func_symbol.arg_types->size - get_register_arg_count(generator->function))
+        return 0;
+    // no value of the current function may be lost
+    for (i = 0; i < ARRLEN(call_clobbered_registers); i++) {
+        if (register_handler_is_register_in_use(generator->reg_handler, call_clobbered_registers[i]))
+            return 0;
+    }
+    return 1;
+}
+
+void generate_tail_call(CodeGenerator *generator, AstNode *node, Symbol *function) {
+    int i, offset, register_arg_count = get_register_arg_count(function);
+    char *eax, *address, *proc_name;
+    Variable *arg;
+    List *args = node->data.function_call.args;
+
+    // evaluate all the arguments before changing the current ones, which they may use
+    for (i = args->size - 1; i >= 0; i--) {
+        generate_arithmetic_expression(generator, &((AstNode *) args->items[i])->data.expression);
+        generate_push(generator, EXPR_RES_REG);
+    }
+    for (i = 0; i < args->size; i++) {
+        if (function != generator->function && i < register_arg_count) {
+            generate_pop(generator, fastcall_arg_registers[i]);
+            continue;
+        }
+        eax = register_handler_request_register(generator->reg_handler, generator->fp, EAX);
+        generate_pop(generator, eax);
+        if (function == generator->function) {
+            // store the argument where the function keeps it (if it is used at all)
+            arg = function->value.func_symbol.arg_types->items[i];
+            if (generator->frame && stack_frame_lookup(generator->frame, arg->name, &offset)) {
+                code_generator_apply_assignment(generator, arg->value->type,
+                                                address = get_var_address(generator, arg->name), eax);
+                free(address);
+                continue;
+            }
+        } else {
+            // replace the stack argument of the current function, above the return address
+            if (generator->frame)
+                alsprintf(&address, "dword [ebp+%d]", 8 + 4 * (i - register_arg_count));
+            else // above the arguments that are still pushed
+                alsprintf(&address, "dword [esp+%d]", 4 * (args->size - 1 - i) + 4 + 4 * (i - register_arg_count));
+            write_to_file(generator->fp, MOV, address, eax);
+            free(address);
+        }
+        register_handler_free_register(generator->reg_handler, generator->fp, eax);
+    }
+
+    if (function == generator->function) {
+        write_to_file(generator->fp, JMP, generator->body_label);
+    } else {
+        if (generator->frame)
+            write_to_file(generator->fp, LEAVE);
+        write_to_file(generator->fp, JMP, proc_name = get_proc_name_formatted(node->data.function_call.func_name));
+        free(proc_name);
+    }
+    generator->tail_call_count++;
+}
+
+void generate_function_call(CodeGenerator *generator, AstNode *node) {
+    int i, register_arg_count, saved_count = 0;
+    char *saved_registers[ARRLEN(call_clobbered_registers)];
+    Symbol *function;
     void (*builtin_func)(CodeGenerator *, AstNode *);
 
     builtin_func = hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name);
     if (builtin_func) { // builtin function
         builtin_func(generator, node);
     } else { // other function
-        for (i = node->data.function_call.args->size - 1; i >= 0; i--) {
+        function = symbol_table_lookup(generator->symbol_table, node->data.function_call.func_name);
+        if (node->data.function_call.is_tail_call && can_generate_tail_call(generator, function)) {
+            generate_tail_call(generator, node, function);
+            write_to_file(generator->fp, "\n");
+            return;
+        }
+        register_arg_count = get_register_arg_count(function);
+        // save the registers that hold values across the call
+        for (i = 0; i < ARRLEN(call_clobbered_registers); i++) {
+            if (register_handler_is_register_in_use(generator->reg_handler, call_clobbered_registers[i])) {
+                generate_push(generator, call_clobbered_registers[i]);
+                saved_registers[saved_count++] = call_clobbered_registers[i];
+            }
+        }
+        // push the stack arguments
+        for (i = node->data.function_call.args->size - 1; i >= register_arg_count; i--) {
+            generate_arithmetic_expression(generator,
+                                           &((AstNode *) node->data.function_call.args->items[i])->data.expression);
+            generate_push(generator, EXPR_RES_REG); // push each argument
+        }
+        // evaluate the register arguments (evaluating an expression may change any of them, so they are kept on
+        // the stack until the last one is evaluated)
+        for (i = register_arg_count - 1; i >= 0; i--) {
             generate_arithmetic_expression(generator,
                                            &((AstNode *) node->data.function_call.args->items[i])->data.expression);
-            write_to_file(generator->fp, PUSH, EXPR_RES_REG); // push each argument
+            if (i > 0)
+                generate_push(generator, EXPR_RES_REG);
+            else
+                write_to_file(generator->fp, MOV, fastcall_arg_registers[0], EXPR_RES_REG);
         }
+        for (i = 1; i < register_arg_count; i++)
+            generate_pop(generator, fastcall_arg_registers[i]);
+
         write_to_file(generator->fp, CALL,
                       get_proc_name_formatted(node->data.function_call.func_name)); // call function
+        // the callee pops the stack arguments
+        generator->reg_handler->stack_depth -= 4 * (node->data.function_call.args->size - register_arg_count);
+        // restore the saved registers
+        while (saved_count > 0)
+            generate_pop(generator, saved_registers[--saved_count]);
+    }
+    write_to_file(generator->fp, "\n");
+}
+
+int can_generate_conditional_move(AstNode *node) {
+    List *body = node->data.if_statement.body_node, *else_body = node->data.if_statement.else_node;
+    AstNode *assignment, *else_assignment;
+
+    if (!node->data.if_statement.condition->data.expression.contains_variables)
+        return 0;
+    if (body->size != 1 || else_body->size > 1)
+        return 0;
+    assignment = body->items[0];
+    if (assignment->type != AST_ASSIGNMENT ||
+        !expression_is_safe_to_speculate(&assignment->data.assignment.expression->data.expression))
+        return 0;
+    if (else_body->size == 0)
+        return 1;
+    // both branches must assign the same variable
+    else_assignment = else_body->items[0];
+    return else_assignment->type == AST_ASSIGNMENT &&
+           strcmp(else_assignment->data.assignment.dst_variable->value,
+                  assignment->data.assignment.dst_variable->value) == 0 &&
+           expression_is_safe_to_speculate(&else_assignment->data.assignment.expression->data.expression);
+}
+
+void generate_conditional_move(CodeGenerator *generator, AstNode *node) {
+    AstNode *assignment = node->data.if_statement.body_node->items[0];
+    AstNode *else_assignment = node->data.if_statement.else_node->size > 0
+                               ? node->data.if_statement.else_node->items[0] : NULL;
+    char *var_name = assignment->data.assignment.dst_variable->value;
+    Symbol *target_var = symbol_table_lookup(generator->symbol_table, var_name);
+    char *eax, *ebx, *cmov_format, *var_address, *format;
+    ExpressionNode *root;
+
+    // the values and the condition have no side effects, so there is nothing to do for a variable that is never read
+    if (!variable_has_storage(generator, var_name))
+        return;
+
+    // both values are computed, and the condition selects one of them
+    generate_arithmetic_expression(generator, &assignment->data.assignment.expression->data.expression);
+    generate_push(generator, EAX);
+    if (else_assignment) {
+        generate_arithmetic_expression(generator, &else_assignment->data.assignment.expression->data.expression);
+        generate_push(generator, EAX);
+    }
+
+    root = expression_tree_from_postfix(node->data.if_statement.condition->data.expression.tokens, generator->lexer);
+    eax = register_handler_request_register(generator->reg_handler, generator->fp, EXPR_RES_REG);
+    ebx = register_handler_request_register(generator->reg_handler, generator->fp, EBX);
+    cmov_format = generate_condition_flags(generator, root);
+
+    // the instructions up to the conditional move keep the flags
+    if (else_assignment) {
+        generate_pop(generator, eax);
+    } else {
+        // without an else, the variable keeps its value when the condition is false
+        var_address = get_var_address(generator, var_name);
+        if (target_var->value.var_symbol.var_size == BYTE)
+            write_to_file(generator->fp, MOVSX, eax, alsprintf(&format, "byte [%s]", var_address));
+        else
+            write_to_file(generator->fp, MOV, eax, alsprintf(&format, "[%s]", var_address));
+        free(format);
+        free(var_address);
     }
+    generate_pop(generator, ebx);
+    // the address of a variable in a frame addressed by ESP changes with the pops
+    var_address = get_var_address(generator, var_name);
+    write_to_file(generator->fp, cmov_format, eax, ebx);
+    register_handler_free_register(generator->reg_handler, generator->fp, ebx);
+    code_generator_apply_assignment(generator, target_var->value.var_symbol.type, var_address, eax);
     write_to_file(generator->fp, "\n");
+
+    generator->conditional_move_count++;
+    free(var_address);
+    expression_tree_dispose(root);
 }
 
 void generate_if_statement(CodeGenerator *generator, AstNode *node) {
-    char *false_label = generate_label(), *done_if = generate_label();
-    // evaluate the condition, result in EAX
-    generate_arithmetic_expression(generator, &node->data.if_statement.condition->data.expression);
+    char *false_label = NULL, *done_if = NULL, *false_target, *done_target;
+    char *exit_label = generator->exit_label;
+    int has_else = node->data.if_statement.else_node->size > 0;
 
-    write_to_file(generator->fp, CMP, EXPR_RES_REG, "0");
-    write_to_file(generator->fp, JE, false_label);
-    // generate body
-    generate_block(generator, node->data.if_statement.body_node);
-    write_to_file(generator->fp, JMP, done_if);
-    // else block
-    write_to_file(generator->fp, LABEL_DEF, false_label);
-    generate_block(generator, node->data.if_statement.else_node);
-    write_to_file(generator->fp, LABEL_DEF, done_if);
+    if (can_generate_conditional_move(node)) {
+        generate_conditional_move(generator, node);
+        return;
+    }
+
+    // if a jump follows the if statement, the branches jump straight to its target (jump threading)
+    false_target = !has_else && exit_label ? exit_label : (false_label = generate_label());
+    // jump over the body if the condition is false
+    generate_condition(generator, &node->data.if_statement.condition->data.expression, 0, false_target);
+    if (has_else) {
+        done_target = exit_label ? exit_label : (done_if = generate_label());
+        // generate body
+        generator->exit_label = done_target;
+        if (!generate_block(generator, node->data.if_statement.body_node))
+            write_to_file(generator->fp, JMP, done_target);
+        // else block
+        write_to_file(generator->fp, LABEL_DEF, false_label);
+        generator->exit_label = exit_label;
+        generate_block(generator, node->data.if_statement.else_node);
+        if (done_if) {
+            write_to_file(generator->fp, LABEL_DEF, done_if);
+            free(done_if);
+        }
+    } else {
+        // generate body
+        generate_block(generator, node->data.if_statement.body_node);
+        if (false_label)
+            write_to_file(generator->fp, LABEL_DEF, false_label);
+    }
 
     write_to_file(generator->fp, "\n");
     free(false_label);
-    free(done_if);
 }
 
 void generate_simple_loop(CodeGenerator *generator, AstNode *node) {
@@ -417,12 +1021,16 @@ void generate_simple_loop(CodeGenerator *generator, AstNode *node) {
         write_to_file(generator->fp, MOV, ecx,
                       alsprintf(&loop_count, "%d", (int) node->data.loop.end->value->value.double_value));
     }
+    generate_code_alignment(generator, compiler_options.align_loops);
     write_to_file(generator->fp, LABEL_DEF, loop_label);
 
     // generate loop body
+    generator->exit_label = NULL;
     generate_block(generator, node->data.loop.body);
 
-    write_to_file(generator->fp, LOOP, loop_label);
+    // `loop` is slower than `dec` and `jnz`, and reaches only 127 bytes back
+    write_to_file(generator->fp, DEC, ecx);
+    write_to_file(generator->fp, JNE, loop_label);
     if (node->data.loop.end->contains_variables) {
         write_to_file(generator->fp, LABEL_DEF, end_loop_label);
         free(end_loop_label);
@@ -433,20 +1041,105 @@ void generate_simple_loop(CodeGenerator *generator, AstNode *node) {
     free(loop_label);
 }
 
+void generate_loop_with_counter_copy(CodeGenerator *generator, AstNode *node, char *loop_counter_form, char *end_reg,
+                                     char *step_reg, int forward) {
+    char *loop_label = generate_label();
+
+    generate_code_alignment(generator, compiler_options.align_loops);
+    write_to_file(generator->fp, LABEL_DEF, loop_label);
+    // generate loop body
+    generator->exit_label = NULL;
+    generate_block(generator, node->data.loop.body);
+    if (step_reg)
+        write_to_file(generator->fp, ADD, loop_counter_form, step_reg);
+    else
+        write_to_file(generator->fp, forward ? INC : DEC, loop_counter_form);
+    write_to_file(generator->fp, CMP, loop_counter_form, end_reg);
+    write_to_file(generator->fp, JNE, loop_label);
+
+    free(loop_label);
+}
+
+int count_innermost_loop_statements(List *block) {
+    int i, count = block->size, inner_count;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+        if (node->type == AST_LOOP || node->type == AST_WHILE_LOOP)
+            return -1;
+        if (node->type == AST_IF_STATEMENT) {
+            if ((inner_count = count_innermost_loop_statements(node->data.if_statement.body_node)) < 0)
+                return -1;
+            count += inner_count;
+            if ((inner_count = count_innermost_loop_statements(node->data.if_statement.else_node)) < 0)
+                return -1;
+            count += inner_count;
+        }
+    }
+    return count;
+}
+
+int can_version_loop(AstNode *node) {
+    int count = count_innermost_loop_statements(node->data.loop.body);
+    return count >= 0 && count <= LOOP_VERSIONING_MAX_STATEMENTS;
+}
+
+void generate_versioned_loop(CodeGenerator *generator, AstNode *node, char *loop_counter_form, char *end_reg,
+                             char *loop_end_label) {
+    char *descending_label = generate_label();
+    int eliminated_count, tail_call_count, conditional_move_count;
+
+    write_to_file(generator->fp, JG, descending_label);
+    generate_loop_with_counter_copy(generator, node, loop_counter_form, end_reg, NULL, 1);
+    write_to_file(generator->fp, JMP, loop_end_label);
+    write_to_file(generator->fp, LABEL_DEF, descending_label);
+    // the statistics count the source loop once
+    eliminated_count = generator->value_numbering->eliminated_count;
+    tail_call_count = generator->tail_call_count;
+    conditional_move_count = generator->conditional_move_count;
+    generate_loop_with_counter_copy(generator, node, loop_counter_form, end_reg, NULL, 0);
+    generator->value_numbering->eliminated_count = eliminated_count;
+    generator->tail_call_count = tail_call_count;
+    generator->conditional_move_count = conditional_move_count;
+
+    free(descending_label);
+}
+
+void generate_loop_with_direction(CodeGenerator *generator, AstNode *node, char *loop_counter_form, char *end_reg,
+                                  char *step_reg) {
+    char *ascending_label = generate_label();
+
+    // the flags hold the comparison of the start with the end
+    write_to_file(generator->fp, MOV, step_reg, "1");
+    write_to_file(generator->fp, JL, ascending_label);
+    write_to_file(generator->fp, NEG, step_reg);
+    write_to_file(generator->fp, LABEL_DEF, ascending_label);
+    generate_loop_with_counter_copy(generator, node, loop_counter_form, end_reg, step_reg, 1);
+
+    free(ascending_label);
+}
+
 void generate_loop_with_counter(CodeGenerator *generator, AstNode *node) {
-    char *loop_label = generate_label(), *loop_end_label = generate_label(), *inc_label = generate_label();
+    char *loop_end_label = generate_label();
     char *loop_counter = node->data.loop.loop_counter_name;
-    char *form2, *loop_counter_form = alsprintf(&loop_counter_form, "dword [%s]", get_var_name_formatted(loop_counter));
-    int loop_range_is_expression = 0;
+    char *form2, *loop_counter_form, *counter_address;
+    // if the start or the end is an expression, the direction is known only at runtime
+    int loop_range_is_expression = node->data.loop.start->contains_variables ||
+                                   node->data.loop.end->contains_variables;
+    int is_versioned = loop_range_is_expression && can_version_loop(node);
+    // requested before the address of the counter is taken, since saving them may move ESP
     char *edi = register_handler_request_register(generator->reg_handler, generator->fp, EDI);
+    char *esi = loop_range_is_expression && !is_versioned
+                ? register_handler_request_register(generator->reg_handler, generator->fp, ESI) : NULL;
+
+    alsprintf(&loop_counter_form, "dword [%s]", counter_address = get_var_address(generator, loop_counter));
+    free(counter_address);
 
     // if end expression needs evaluation
     if (node->data.loop.end->contains_variables) {
-        loop_range_is_expression = 1;
         generate_arithmetic_expression(generator, node->data.loop.end);
-
         write_to_file(generator->fp, MOV, edi, EAX); // store `end` in EDI
-        write_to_file(generator->fp, CMP, loop_counter_form, edi);
     } else {
         write_to_file(generator->fp, MOV, edi,
                       alsprintf(&form2, "%d",
@@ -455,7 +1148,6 @@ void generate_loop_with_counter(CodeGenerator *generator, AstNode *node) {
     }
     // if start expression needs evaluation
     if (node->data.loop.start->contains_variables) {
-        loop_range_is_expression = 1;
         // evaluate start expression, result in EAX
         generate_arithmetic_expression(generator, node->data.loop.start);
         write_to_file(generator->fp, MOV, loop_counter_form, EAX);
@@ -465,29 +1157,21 @@ void generate_loop_with_counter(CodeGenerator *generator, AstNode *node) {
         free(form2);
     }
 
-    write_to_file(generator->fp, LABEL_DEF, loop_label);
-
+    // the loop is rotated: the range is tested once on entry, and then at the bottom of every iteration
     write_to_file(generator->fp, CMP, loop_counter_form, edi);
     write_to_file(generator->fp, JE, loop_end_label);
-    write_to_file(generator->fp, "\n");
-    // generate loop body
-    generate_block(generator, node->data.loop.body);
-    // if the start or the end is an expression
-    if (loop_range_is_expression) {
-        write_to_file(generator->fp, CMP, loop_counter_form, edi);
-        write_to_file(generator->fp, JL, inc_label);
-        write_to_file(generator->fp, DEC, loop_counter_form);
-        write_to_file(generator->fp, JMP, loop_label);
-        write_to_file(generator->fp, LABEL_DEF, inc_label);
-        write_to_file(generator->fp, INC, loop_counter_form);
-        write_to_file(generator->fp, JMP, loop_label);
-    } else {
-        write_to_file(generator->fp, node->data.loop.forward ? INC : DEC, loop_counter_form);
-        write_to_file(generator->fp, JMP, loop_label);
-    }
+    if (!loop_range_is_expression)
+        generate_loop_with_counter_copy(generator, node, loop_counter_form, edi, NULL, node->data.loop.forward);
+    else if (is_versioned)
+        generate_versioned_loop(generator, node, loop_counter_form, edi, loop_end_label);
+    else
+        generate_loop_with_direction(generator, node, loop_counter_form, edi, esi);
     write_to_file(generator->fp, LABEL_DEF, loop_end_label);
 
+    free(loop_end_label);
     free(loop_counter_form);
+    if (esi)
+        register_handler_free_register(generator->reg_handler, generator->fp, esi);
     register_handler_free_register(generator->reg_handler, generator->fp, edi);
 }
 
@@ -499,15 +1183,18 @@ void generate_loop(CodeGenerator *generator, AstNode *node) {
 
 void generate_while_loop(CodeGenerator *generator, AstNode *node) {
     char *while_label = generate_label(), *end_loop = generate_label();
+
+    // the loop is rotated: the condition is tested once on entry, and then at the bottom of every iteration,
+    // so an iteration takes a single branch
+    generate_condition(generator, &node->data.while_loop.condition->data.expression, 0, end_loop);
+    generate_code_alignment(generator, compiler_options.align_loops);
     write_to_file(generator->fp, LABEL_DEF, while_label);
-    generate_arithmetic_expression(generator, &node->data.while_loop.condition->data.expression);
-    write_to_file(generator->fp, CMP, EAX, "0");
-    write_to_file(generator->fp, JE, end_loop);
     write_to_file(generator->fp, "\n");
     // generate body
+    generator->exit_label = NULL;
     generate_block(generator, node->data.while_loop.body);
 
-    write_to_file(generator->fp, JMP, while_label);
+    generate_condition(generator, &node->data.while_loop.condition->data.expression, 1, while_label);
     write_to_file(generator->fp, LABEL_DEF, end_loop);
 
     free(while_label);
@@ -515,19 +1202,11 @@ void generate_while_loop(CodeGenerator *generator, AstNode *node) {
 }
 
 void generate_return_statement(CodeGenerator *generator, AstNode *node) {
-    unsigned int arg_count = node->data.return_statement.parent_function_arg_count;
-
     if (node->data.return_statement.value_expr->data.expression.value->type != TYPE_VOID) {
         generate_arithmetic_expression(generator, &node->data.return_statement.value_expr->data.expression);
     }
 
-    if (arg_count == 0) {
-        // no args
-        write_to_file(generator->fp, RET);
-    } else {
-        write_to_file(generator->fp, POP, EBP);
-        write_to_file(generator->fp, RET_NUM, arg_count * 4);
-    }
+    generate_function_epilogue(generator);
 }
 
 void generate_swap_statement(CodeGenerator *generator, AstNode *node) {
@@ -538,8 +1217,8 @@ void generate_swap_statement(CodeGenerator *generator, AstNode *node) {
     sym_b = symbol_table_lookup(generator->symbol_table, var_b->value);
     reg = register_handler_request_register(generator->reg_handler, generator->fp,
                                             sym_a->value.var_symbol.var_size == BYTE ? AL : EAX);
-    alsprintf(&var_a_format, "[%s]", get_var_name_formatted(sym_a->value.var_symbol.var_name));
-    alsprintf(&var_b_format, "[%s]", get_var_name_formatted(sym_b->value.var_symbol.var_name));
+    alsprintf(&var_a_format, "[%s]", get_var_address(generator, sym_a->value.var_symbol.var_name));
+    alsprintf(&var_b_format, "[%s]", get_var_address(generator, sym_b->value.var_symbol.var_name));
 
     write_to_file(generator->fp, MOV, reg, var_a_format);
     write_to_file(generator->fp, XCHG, reg, var_b_format);
@@ -5,13 +5,16 @@
 #include "../symbol_table/symbol_table.h"
 #include "register_handler.h"
 #include "../lexer/lexer.h"
+#include "../expression_evaluator/expression_tree.h"
+#include "value_numbering.h"
+#include "stack_frame.h"
 
 #define EXPR_RES_REG EAX
 
 /** Naming Conventions */
 #define ENTRY_POINT_NAME "_start"
 /** Helper Procedures */
-#define INCLUDE_ASM_PATH "../config/include.asm"
+// embedded from config/include.asm (see config/include_asm.h), unless -fruntime is given
 
 #define EXIT_PROC "Exit"
 #define EXIT_ZERO_DIV_PROC "ExitZeroDiv"
@@ -21,9 +24,39 @@
 #define PRINT_NEW_LINE_PROC "PrintNewLine"
 #define PRINT_INT_PROC "PrintInt"
 #define PRINT_CHAR_PROC "PrintChar"
+#define FLUSH_OUTPUT_PROC "FlushOutput"
+// arguments of the helper procedures that print (the text and its length, or the number or the character)
+#define HELPER_FIRST_ARG_REG ECX
+#define HELPER_SECOND_ARG_REG EDX
 
 #define TRUE_STR_VAR "true_str"
 #define FALSE_STR_VAR "false_str"
+#define DIGIT_PAIRS_VAR "digit_pairs"
+// the output of print is collected in a buffer, and written when it is full and when the program exits
+#define OUTPUT_BUFFER_VAR "out_stream"
+#define OUTPUT_BUFFER_SIZE_NAME "out_stream_size"
+#define OUTPUT_BUFFER_LENGTH_VAR "out_stream_len"
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+#define PROGRAM_OUTPUT_VAR "program_output"
+// number of bytes of the precomputed output in each line of the data segment
+#define PROGRAM_OUTPUT_LINE_BYTES 16
+
+/** Calling Convention */
+// Functions marked as fastcall by the semantic analyzer take their first FASTCALL_ARG_COUNT arguments in
+// FASTCALL_ARG_REGISTERS (in order), and the rest on the stack (the last argument pushed first).
+// The callee pops the stack arguments (`ret N`).
+// A call may change EAX (the returned value), EBX, ECX, EDX, ESI and EDI, so the caller saves the ones it keeps
+// values in across the call (loop counters) - see call_clobbered_registers.
+// The helper procedures that print take their arguments in ECX and EDX, and change only EAX, ECX and EDX, so the
+// caller saves just these two - see helper_clobbered_registers.
+#define FASTCALL_ARG_COUNT 2
+#define FASTCALL_ARG_REGISTERS {ECX, EDX}
+
+/** Loop Versioning */
+// A counted loop whose range is known only at runtime is generated as an ascending and a descending copy, if it is an
+// innermost loop with up to LOOP_VERSIONING_MAX_STATEMENTS statements. Other such loops step their counter by a
+// direction that is computed before the loop.
+#define LOOP_VERSIONING_MAX_STATEMENTS 12
 
 typedef struct CodeGenerator {
     SymbolTable *symbol_table;
@@ -35,6 +68,14 @@ typedef struct CodeGenerator {
     char *target_path; // output file path
     FILE *fp; // target file pointer
 
+    ValueNumbering *value_numbering; // repeated computations in the current basic block
+    StackFrame *frame; // frame of the function being generated. NULL outside functions and in functions without one
+    Symbol *function; // symbol of the function being generated
+    char *body_label; // label after the prologue of the function being generated, for self tail calls. may be NULL
+    char *exit_label; // label the current statement jumps to when it ends, NULL if it falls through to the next code
+    int tail_call_count; // number of calls turned into jumps
+    int conditional_move_count; // number of if statements turned into conditional moves
+
     Lexer *lexer; // for error reporting
 } CodeGenerator;
 
@@ -47,11 +88,36 @@ void dispose_code_generator(CodeGenerator *generator);
 /// \param generator Code generator instance
 void code_generator_generate(CodeGenerator *generator);
 
+/// Generates a program that writes a precomputed output with a single `write`, and exits with a precomputed exit code.
+/// Used for programs that were run at compile time (-fpartial-evaluation), instead of code_generator_generate.
+/// \param generator Code generator instance
+/// \param output
+/// \param output_length
+/// \param exit_code
+void code_generator_generate_precomputed(CodeGenerator *generator, char *output, int output_length, int exit_code);
+
 /// Generates the Data Segment of a program
 /// \param generator
 void generate_data_segment(CodeGenerator *generator);
 
-/// Generates the BSS segment, containing all the variables used in the program
+/// Whether a variable should be laid out before another one in memory.
+/// Dwords come before bytes, so they stay aligned. With -fhot-data-first, variables used in deeper loops come first.
+/// \param symbol_a
+/// \param symbol_b
+/// \return Boolean
+int is_laid_out_before(Symbol *symbol_a, Symbol *symbol_b);
+
+/// Inserts a variable into a list of variables sorted by the layout order (see is_laid_out_before)
+/// \param layout
+/// \param symbol
+void insert_in_layout_order(List *layout, Symbol *symbol);
+
+/// Whether the type of a variable takes storage (bool, char, int and string variables)
+/// \param symbol
+/// \return Boolean
+int is_stored_variable(Symbol *symbol);
+
+/// Generates the BSS segment, containing the global variables of the program, aligned to their size
 /// \param generator
 void generate_bss_segment(CodeGenerator *generator);
 
@@ -59,6 +125,52 @@ void generate_bss_segment(CodeGenerator *generator);
 /// \param generator
 void generate_code_segment(CodeGenerator *generator);
 
+/// Aligns the next instruction in the code segment, for labels that are jumped to often (function entries and loop
+/// heads). The padding is made of NOP instructions.
+/// \param generator
+/// \param alignment Alignment in bytes, 1 for none
+void generate_code_alignment(CodeGenerator *generator, int alignment);
+
+/// Returns the address of a slot of the current stack frame, to be used inside brackets.
+/// A frame addressed by ESP is offset by the bytes pushed since the prologue, so the address is valid only until
+/// the next push or pop.
+/// \param generator
+/// \param offset Offset of the slot in the frame
+/// \return Allocated string
+char *get_frame_address(CodeGenerator *generator, int offset);
+
+/// Returns the address of a variable, to be used inside brackets:
+/// in the stack frame for the arguments and local variables of the current function (see get_frame_address), the
+/// variable label for global variables
+/// \param generator
+/// \param var_name
+/// \return Allocated string
+char *get_var_address(CodeGenerator *generator, char *var_name);
+
+/// Returns the address of a temporary in the current stack frame, to be used inside brackets
+/// \param generator
+/// \param temp_index
+/// \return Allocated string
+char *get_temp_address(CodeGenerator *generator, int temp_index);
+
+/// Generates a second data segment for the string literals that the code segment refers to.
+/// Generated after the code segment, so the strings of the functions that are not generated are left out.
+/// \param generator
+void generate_string_literals(CodeGenerator *generator);
+
+/// Looks up the symbol of a string literal, and marks it as used so it is generated
+/// \param generator
+/// \param value The value of the string
+/// \return The string symbol
+StringSymbol *get_string_symbol(CodeGenerator *generator, char *value);
+
+/// Whether a variable has storage: a slot in the current stack frame, or in the .bss segment for a global variable.
+/// Variables that are never read have none, so their stores are dropped.
+/// \param generator
+/// \param var_name
+/// \return 1 if the variable has storage, 0 otherwise
+int variable_has_storage(CodeGenerator *generator, char *var_name);
+
 char *get_variable_size_prefix(CodeGenerator *generator, char *var_name);
 
 void code_generator_apply_assignment(CodeGenerator *generator, DataType var_type, char *var_name, char *reg);
@@ -71,25 +183,187 @@ int generate_block(CodeGenerator *generator, List *block);
 
 void generate_statement(CodeGenerator *generator, AstNode *node);
 
-/// Generates an arithmetic expression with variables
+/// Generates an arithmetic expression with variables. The result is stored in EAX.
+/// The expression is converted to a tree and generated recursively, so sub-expressions can be skipped.
 /// \param generator
 /// \param postfix_expr_lst List of the expression's tokens, in postfix.
 void generate_complicated_arithmetic_expression(CodeGenerator *generator, List *postfix_expr_lst);
 
 void generate_arithmetic_expression(CodeGenerator *generator, Expression *expr);
 
+/// Generates an expression sub-tree, the result is stored in EAX.
+/// Expects EAX and EBX to be requested by the caller.
+/// \param generator
+/// \param node Root of the sub-tree
+void generate_expression_node(CodeGenerator *generator, ExpressionNode *node);
+
+/// Stores the value in EAX to its temporary, if the value numbering found that it is used again later.
+/// \param generator
+/// \param value_entry Annotation of the computed node (can be NULL)
+void generate_value_store(CodeGenerator *generator, ValueNumberEntry *value_entry);
+
+/// Whether evaluating an expression sub-tree has no effect other than its value, and is cheap,
+/// so it can be evaluated even when its value is not used
+/// \param node Root of the sub-tree (can be NULL)
+/// \return Boolean
+int expression_node_is_safe_to_speculate(ExpressionNode *node);
+
+/// Whether evaluating an expression has no effect other than its value, and is cheap (see
+/// expression_node_is_safe_to_speculate)
+/// \param expr
+/// \return Boolean
+int expression_is_safe_to_speculate(Expression *expr);
+
+/// Generates the value of an expression sub-tree as 0/1 in EAX.
+/// Expects EAX and EBX to be requested by the caller.
+/// \param generator
+/// \param node
+void generate_boolean_value(CodeGenerator *generator, ExpressionNode *node);
+
+/// Generates the 0/1 value of an `and` / `or` node.
+/// If the right operand is safe to evaluate, both operands are evaluated and combined without branches.
+/// Otherwise, it is evaluated only when the left operand does not determine the result (short-circuit).
+/// \param generator
+/// \param node Logical operator node
+void generate_logical_expression_node(CodeGenerator *generator, ExpressionNode *node);
+
+/// Returns an operand that can be used directly as the source of an instruction (like `cmp eax, <operand>`),
+/// for nodes that do not require evaluation: numbers and dword variables.
+/// \param generator
+/// \param node
+/// \return Allocated string of the operand, or NULL if the node has to be evaluated into a register
+char *get_expression_node_operand(CodeGenerator *generator, ExpressionNode *node);
+
 void generate_variable_declaration(CodeGenerator *generator, AstNode *node);
 
 void generate_assignment(CodeGenerator *generator, AstNode *node);
 
+/// Whether a function calls no other function (builtin functions aside)
+/// \param function Function symbol
+/// \return Boolean
+int is_leaf_function(Symbol *function);
+
+/// Builds the stack frame of a function: its arguments and the local variables it references.
+/// Leaf functions omit the frame pointer: their frame is addressed by ESP.
+/// \param generator
+/// \param node Function definition node
+/// \return The frame, or NULL if the function references no variable
+StackFrame *build_stack_frame(CodeGenerator *generator, AstNode *node);
+
+/// Returns the number of arguments a function takes in registers
+/// \param function Function symbol
+/// \return
+int get_register_arg_count(Symbol *function);
+
+/// Generates the return from the current function: releases its stack frame and pops the stack arguments
+/// \param generator
+void generate_function_epilogue(CodeGenerator *generator);
+
+/// Generates a function, aligned by -falign-functions. The arguments and local variables are in a stack frame
+/// addressed by EBP, so every call has its own copy of them (and recursion works).
+/// Leaf functions address the frame by ESP instead, and don't set up EBP.
+/// \param generator
+/// \param node
 void generate_function(CodeGenerator *generator, AstNode *node);
 
+/// Prepares a call to a helper procedure that prints: saves the registers it changes that hold values (like the counter
+/// of a loop), and marks them as used.
+/// \param generator
+void request_helper_registers(CodeGenerator *generator);
+
+/// Restores the registers saved by request_helper_registers, after the call.
+/// \param generator
+void free_helper_registers(CodeGenerator *generator);
+
+/// Whether a call marked as a tail call can reuse the frame of the current function:
+/// calls to the function itself, and calls to functions that take as many stack arguments as the current one.
+/// \param generator
+/// \param function Symbol of the called function
+/// \return Boolean
+int can_generate_tail_call(CodeGenerator *generator, Symbol *function);
+
+/// Generates a call in tail position as a jump. The new arguments replace the arguments of the current function:
+/// a call to the function itself jumps back to its body, and a call to another function releases the frame and
+/// jumps to it, so it returns directly to the caller of the current function.
+/// \param generator
+/// \param node Function call node
+/// \param function Symbol of the called function
+void generate_tail_call(CodeGenerator *generator, AstNode *node, Symbol *function);
+
+/// Generates a function call. Builtin functions are generated by their own generators.
+/// The arguments are passed according to the calling convention of the function (see FASTCALL_ARG_COUNT),
+/// and the registers that hold values of the caller are saved around the call.
+/// \param generator
+/// \param node
 void generate_function_call(CodeGenerator *generator, AstNode *node);
 
+/// Whether an if statement can be generated as a conditional move:
+/// its body assigns a variable, and its else block (if any) assigns the same variable, with expressions that are
+/// safe to evaluate regardless of the condition.
+/// \param node If statement node
+/// \return Boolean
+int can_generate_conditional_move(AstNode *node);
+
+/// Generates an if statement without branches: the values of both branches are computed,
+/// and a conditional move selects the one that is assigned.
+/// \param generator
+/// \param node If statement node
+void generate_conditional_move(CodeGenerator *generator, AstNode *node);
+
+/// Generates an if statement. Small ifs that assign a variable are generated as conditional moves.
+/// When the if statement is followed by a jump (the end of an enclosing if body), its body jumps to the target of
+/// that jump directly.
+/// \param generator
+/// \param node
 void generate_if_statement(CodeGenerator *generator, AstNode *node);
 
 void generate_simple_loop(CodeGenerator *generator, AstNode *node);
 
+/// Generates the body of a counted loop, followed by a counter step and the bottom test.
+/// The range must be tested on entry by the caller.
+/// \param generator
+/// \param node Loop node
+/// \param loop_counter_form Memory operand of the loop counter
+/// \param end_reg Register holding the end of the range
+/// \param step_reg Register holding the step of the counter (1 or -1), or NULL to step it in a fixed direction
+/// \param forward Whether the counter goes up, when there is no step register
+void generate_loop_with_counter_copy(CodeGenerator *generator, AstNode *node, char *loop_counter_form, char *end_reg,
+                                     char *step_reg, int forward);
+
+/// Counts the statements in the body of an innermost loop (including the statements in nested blocks)
+/// \param block List of statements
+/// \return Number of statements, or -1 if the block contains a loop
+int count_innermost_loop_statements(List *block);
+
+/// Whether a counted loop with a runtime range can be generated as an ascending and a descending copy:
+/// it is an innermost loop with at most LOOP_VERSIONING_MAX_STATEMENTS statements.
+/// \param node Loop node
+/// \return Boolean
+int can_version_loop(AstNode *node);
+
+/// Generates an ascending and a descending copy of a counted loop, and dispatches to one of them by the flags of the
+/// entry test.
+/// \param generator
+/// \param node Loop node
+/// \param loop_counter_form Memory operand of the loop counter
+/// \param end_reg Register holding the end of the range
+/// \param loop_end_label Label after the loop
+void generate_versioned_loop(CodeGenerator *generator, AstNode *node, char *loop_counter_form, char *end_reg,
+                             char *loop_end_label);
+
+/// Generates a single copy of a counted loop, which steps its counter by a direction (1 or -1) that is set by the
+/// flags of the entry test.
+/// \param generator
+/// \param node Loop node
+/// \param loop_counter_form Memory operand of the loop counter
+/// \param end_reg Register holding the end of the range
+/// \param step_reg Register for the direction
+void generate_loop_with_direction(CodeGenerator *generator, AstNode *node, char *loop_counter_form, char *end_reg,
+                                  char *step_reg);
+
+/// Generates a counted loop. When the range is known only at runtime, the direction is checked once before the loop.
+/// \param generator
+/// \param node Loop node
 void generate_loop_with_counter(CodeGenerator *generator, AstNode *node);
 
 void generate_loop(CodeGenerator *generator, AstNode *node);
@@ -0,0 +1,147 @@
+#include "condition_generators.h"
+#include "instruction_generators.h"
+#include "../io/io.h"
+#include <stdlib.h>
+#include <string.h>
+
+void generate_condition(CodeGenerator *generator, Expression *condition, int jump_when, char *target_label) {
+    ExpressionNode *root;
+    char *eax, *ebx;
+
+    // constant condition - the jump is either always or never taken
+    if (!condition->contains_variables) {
+        if ((condition->value->value.double_value != 0) == jump_when)
+            write_to_file(generator->fp, JMP, target_label);
+        return;
+    }
+
+    root = expression_tree_from_postfix(condition->tokens, generator->lexer);
+    eax = register_handler_request_register(generator->reg_handler, generator->fp, EXPR_RES_REG);
+    ebx = register_handler_request_register(generator->reg_handler, generator->fp, EBX);
+
+    generate_condition_node(generator, root, jump_when, target_label);
+
+    register_handler_free_register(generator->reg_handler, generator->fp, eax);
+    register_handler_free_register(generator->reg_handler, generator->fp, ebx);
+    expression_tree_dispose(root);
+}
+
+void generate_condition_node(CodeGenerator *generator, ExpressionNode *node, int jump_when, char *target_label) {
+    char *skip_label, *operand;
+
+    if (expression_node_is_operator(node, OP_LOGICAL_AND) || expression_node_is_operator(node, OP_LOGICAL_OR)) {
+        // an `and` that jumps when false (or an `or` that jumps when true) jumps on either operand
+        if (expression_node_is_operator(node, OP_LOGICAL_AND) != jump_when) {
+            // the first operand alone can decide the result
+            generate_condition_node(generator, node->left, jump_when, target_label);
+            generate_condition_node(generator, node->right, jump_when, target_label);
+        } else {
+            // the first operand can only rule the jump out
+            skip_label = generate_label();
+            generate_condition_node(generator, node->left, !jump_when, skip_label);
+            generate_condition_node(generator, node->right, jump_when, target_label);
+            write_to_file(generator->fp, LABEL_DEF, skip_label);
+            free(skip_label);
+        }
+    } else if (expression_node_is_operator(node, OP_NOT)) {
+        generate_condition_node(generator, node->right, !jump_when, target_label);
+    } else if (node->token->type == OPERATOR && is_relational_operator(node->token->value.op)) {
+        generate_relational_condition(generator, node, jump_when, target_label);
+    } else if (node->token->type == NUMBER) {
+        if ((node->token->value.number != 0) == jump_when)
+            write_to_file(generator->fp, JMP, target_label);
+    } else {
+        if (node->token->type == VAR) {
+            // compare the variable in memory directly
+            alsprintf(&operand, "%s[%s]", get_variable_size_prefix(generator, node->token->value.var),
+                      get_var_address(generator, node->token->value.var));
+            write_to_file(generator->fp, CMP, operand, "0");
+            free(operand);
+        } else {
+            generate_expression_node(generator, node);
+            write_to_file(generator->fp, TEST, EXPR_RES_REG, EXPR_RES_REG);
+        }
+        write_to_file(generator->fp, jump_when ? JNE : JE, target_label);
+    }
+}
+
+void generate_relational_condition(CodeGenerator *generator, ExpressionNode *node, int jump_when, char *target_label) {
+    generate_relational_compare(generator, node);
+    write_to_file(generator->fp, get_relational_jump(node->token->value.op, jump_when), target_label);
+}
+
+void generate_relational_compare(CodeGenerator *generator, ExpressionNode *node) {
+    char *left_operand, *right_operand;
+    int value;
+
+    right_operand = get_expression_node_operand(generator, node->right);
+    if (node->left->token->type == VAR && node->right->token->type == NUMBER) {
+        // compare the variable in memory to the immediate: cmp dword [a], imm
+        value = (int) node->right->token->value.number;
+        if (symbol_table_lookup(generator->symbol_table, node->left->token->value.var)->value.var_symbol.var_size ==
+            DWORD || (value >= -128 && value <= 127)) {
+            alsprintf(&left_operand, "%s[%s]", get_variable_size_prefix(generator, node->left->token->value.var),
+                      get_var_address(generator, node->left->token->value.var));
+            write_to_file(generator->fp, CMP, left_operand, right_operand);
+            free(left_operand);
+            free(right_operand);
+            return;
+        }
+    }
+
+    if (right_operand) {
+        // cmp eax, imm / cmp eax, [b]
+        generate_expression_node(generator, node->left);
+        write_to_file(generator->fp, CMP, EXPR_RES_REG, right_operand);
+        free(right_operand);
+    } else {
+        // evaluate the left operand first, then compare it to the right operand
+        generate_expression_node(generator, node->left);
+        generate_push(generator, EXPR_RES_REG);
+        generate_expression_node(generator, node->right);
+        generate_pop(generator, EBX);
+        write_to_file(generator->fp, CMP, EBX, EXPR_RES_REG);
+    }
+}
+
+char *generate_condition_flags(CodeGenerator *generator, ExpressionNode *node) {
+    if (node->token->type == OPERATOR && is_relational_operator(node->token->value.op)) {
+        generate_relational_compare(generator, node);
+        return get_relational_cmov(node->token->value.op);
+    }
+    generate_expression_node(generator, node);
+    write_to_file(generator->fp, TEST, EXPR_RES_REG, EXPR_RES_REG);
+    return CMOVNE;
+}
+
+char *get_relational_jump(char *op, int jump_when) {
+    if (strcmp(op, OP_EQUALITY) == 0)
+        return jump_when ? JE : JNE;
+    if (strcmp(op, OP_NOT_EQUAL) == 0)
+        return jump_when ? JNE : JE;
+    if (strcmp(op, OP_GRATER_THAN) == 0)
+        return jump_when ? JG : JLE;
+    if (strcmp(op, OP_GRATER_EQUAL) == 0)
+        return jump_when ? JGE : JL;
+    if (strcmp(op, OP_LOWER_THAN) == 0)
+        return jump_when ? JL : JGE;
+    if (strcmp(op, OP_LOWER_EQUAL) == 0)
+        return jump_when ? JLE : JG;
+    return NULL;
+}
+
+char *get_relational_cmov(char *op) {
+    if (strcmp(op, OP_EQUALITY) == 0)
+        return CMOVE;
+    if (strcmp(op, OP_NOT_EQUAL) == 0)
+        return CMOVNE;
+    if (strcmp(op, OP_GRATER_THAN) == 0)
+        return CMOVG;
+    if (strcmp(op, OP_GRATER_EQUAL) == 0)
+        return CMOVGE;
+    if (strcmp(op, OP_LOWER_THAN) == 0)
+        return CMOVL;
+    if (strcmp(op, OP_LOWER_EQUAL) == 0)
+        return CMOVLE;
+    return NULL;
+}
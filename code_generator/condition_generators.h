@@ -0,0 +1,52 @@
+#ifndef INFINITY_COMPILER_CONDITION_GENERATORS_H
+#define INFINITY_COMPILER_CONDITION_GENERATORS_H
+
+#include "code_generator.h"
+#include "../expression_evaluator/expression_tree.h"
+
+/// Generates a condition in "control-flow mode": instead of computing the 0/1 value of the condition,
+/// jumps directly to `target_label` if the condition's truth value equals `jump_when`, and falls through otherwise.
+/// \param generator
+/// \param condition The condition expression
+/// \param jump_when Whether to jump when the condition is true (1) or false (0)
+/// \param target_label Label to jump to
+void generate_condition(CodeGenerator *generator, Expression *condition, int jump_when, char *target_label);
+
+/// Generates a condition sub-tree in control-flow mode. Logical operators become jump chains,
+/// a relational operator becomes a `cmp` followed by a conditional jump.
+/// \param generator
+/// \param node Root of the condition sub-tree
+/// \param jump_when Whether to jump when the condition is true (1) or false (0)
+/// \param target_label Label to jump to
+void generate_condition_node(CodeGenerator *generator, ExpressionNode *node, int jump_when, char *target_label);
+
+/// Generates a comparison (==, !=, >, >=, <, <=) followed by a conditional jump.
+/// \param generator
+/// \param node Relational operator node
+/// \param jump_when Whether to jump when the comparison holds (1) or not (0)
+/// \param target_label Label to jump to
+void generate_relational_condition(CodeGenerator *generator, ExpressionNode *node, int jump_when, char *target_label);
+
+/// Generates a comparison (==, !=, >, >=, <, <=) that sets the flags, without a jump.
+/// \param generator
+/// \param node Relational operator node
+void generate_relational_compare(CodeGenerator *generator, ExpressionNode *node);
+
+/// Generates a condition sub-tree that only sets the flags, for a conditional move.
+/// \param generator
+/// \param node Root of the condition sub-tree
+/// \return Format of the conditional move (like CMOVE) that moves when the condition holds
+char *generate_condition_flags(CodeGenerator *generator, ExpressionNode *node);
+
+/// Returns the conditional jump instruction format for a relational operator.
+/// \param op The relational operator
+/// \param jump_when Whether the jump should be taken when the comparison holds (1) or not (0)
+/// \return Instruction format (like JE), or NULL if `op` is not a relational operator
+char *get_relational_jump(char *op, int jump_when);
+
+/// Returns the conditional move instruction format for a relational operator.
+/// \param op The relational operator
+/// \return Instruction format (like CMOVE), or NULL if `op` is not a relational operator
+char *get_relational_cmov(char *op);
+
+#endif //INFINITY_COMPILER_CONDITION_GENERATORS_H
@@ -16,3 +16,13 @@ char *get_var_name_formatted(char *var_name) {
     char *var_formatted;
     return alsprintf(&var_formatted, VAR_FORMAT, var_name);
 }
+
+void generate_push(CodeGenerator *generator, char *operand) {
+    write_to_file(generator->fp, PUSH, operand);
+    generator->reg_handler->stack_depth += 4;
+}
+
+void generate_pop(CodeGenerator *generator, char *operand) {
+    write_to_file(generator->fp, POP, operand);
+    generator->reg_handler->stack_depth -= 4;
+}
@@ -8,9 +8,18 @@
 #define PROC_FORMAT "P_%s"
 #define VAR_FORMAT "v_%s"
 #define STRING_FORMAT "s_%d"
+#define FRAME_ADDRESS_FORMAT "ebp%+d"
+// ESP + frame size + offset from the return address + bytes pushed since the prologue
+#define ESP_FRAME_ADDRESS_FORMAT "esp+%s%+d"
+#define FRAME_SIZE_FORMAT "%s_frame_size"
 /** Reserve */
 #define RESB " resb %d\n"
 #define RESD " resd %d\n"
+#define ALIGNB "\talignb %d\n"
+#define ALIGN "\talign %d\n"
+#define ALIGN_MODE "alignmode %s\n"
+#define USE_PACKAGE "%%use %s\n"
+#define EQU "%s equ %d\n"
 // label definition in the code
 #define SECTION "section .%s\n"
 #define LABEL_DEF "%s:\n"
@@ -31,6 +40,7 @@
 #define CALL "\tcall %s\n"
 #define RET_NUM "\tret %d\n"
 #define RET "\tret\n"
+#define LEAVE "\tleave\n"
 
 #define SYSCALL_80H "\tint 0x80\n"
 
@@ -50,6 +60,7 @@
 #define SHR "\tshr %s, %s\n"
 
 #define CMP "\tcmp %s, %s\n"
+#define TEST "\ttest %s, %s\n"
 #define LOOP "\tloop %s\n"
 
 #define JMP "\tjmp %s\n"
@@ -80,6 +91,13 @@
 #define SETL "\tsetl %s\n"
 #define SETLE "\tsetle %s\n"
 
+#define CMOVE "\tcmove %s, %s\n"
+#define CMOVNE "\tcmovne %s, %s\n"
+#define CMOVG "\tcmovg %s, %s\n"
+#define CMOVGE "\tcmovge %s, %s\n"
+#define CMOVL "\tcmovl %s, %s\n"
+#define CMOVLE "\tcmovle %s, %s\n"
+
 /// Generates a unique label name and returns it (as new allocated string)
 /// \return Allocated-string of the label name
 char *generate_label();
@@ -94,4 +112,14 @@ char *get_proc_name_formatted(char *proc_name);
 /// \return
 char *get_var_name_formatted(char *var_name);
 
+/// Generates a `push`, and counts the pushed bytes in the stack depth (frames addressed by ESP depend on it)
+/// \param generator
+/// \param operand
+void generate_push(CodeGenerator *generator, char *operand);
+
+/// Generates a `pop`, and removes the popped bytes from the stack depth
+/// \param generator
+/// \param operand
+void generate_pop(CodeGenerator *generator, char *operand);
+
 #endif //INFINITY_COMPILER_INSTRUCTION_GENERATORS_H
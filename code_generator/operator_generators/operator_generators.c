@@ -5,69 +5,71 @@
 
 void generate_op_addition(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                           char *right_op_placeholder, int is_last) {
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, ADD, reg_a, reg_b);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, reg_a);
+        generate_push(generator, reg_a);
 }
 
 void generate_op_subtraction(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                              char *right_op_placeholder, int is_last) {
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, SUB, reg_a, reg_b);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, reg_a);
+        generate_push(generator, reg_a);
 }
 
 void generate_op_multiplication(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                                 char *right_op_placeholder, int is_last) {
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, IMUL, reg_b);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, reg_a);
+        generate_push(generator, reg_a);
 }
 
 void generate_op_division(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                           char *right_op_placeholder, int is_last) {
-    char *edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
-    char *ok_label = generate_label();
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    char *edx, *ok_label = generate_label();
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
+    // requested after the operands are popped, and freed before the result is pushed, since saving EDX pushes it
+    edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, CMP, reg_b, "0");
     write_to_file(generator->fp, JNE, ok_label);
     write_to_file(generator->fp, CALL, EXIT_ZERO_DIV_PROC); // exit on zero division
     write_to_file(generator->fp, LABEL_DEF, ok_label);
     write_to_file(generator->fp, XOR, edx, edx);
     write_to_file(generator->fp, IDIV, reg_b);
-    if (!is_last)
-        write_to_file(generator->fp, PUSH, reg_a);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
+    if (!is_last)
+        generate_push(generator, reg_a);
     free(ok_label);
 }
 
 void generate_op_power(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                        char *right_op_placeholder, int is_last) {
     write_to_file(generator->fp, CALL, POWER_PROC);
+    generator->reg_handler->stack_depth -= 8; // Power pops its operands
     if (!is_last)
-        write_to_file(generator->fp, PUSH, EAX);
+        generate_push(generator, EAX);
 }
 
 void generate_op_modulus(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                          char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, XOR, edx, edx);
     write_to_file(generator->fp, IDIV, reg_b);
-    if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
-    else
-        write_to_file(generator->fp, MOV, reg_a, edx);
+    write_to_file(generator->fp, MOV, reg_a, edx);
+    // freed before the result is pushed, since restoring EDX pops it
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
+    if (!is_last)
+        generate_push(generator, reg_a);
 }
 
 void generate_op_factorial(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
@@ -78,53 +80,9 @@ void generate_op_factorial(CodeGenerator *generator, char *reg_a, char *reg_b, c
         exit(1);
     }
     write_to_file(generator->fp, CALL, FACT_PROC);
+    generator->reg_handler->stack_depth -= 4; // Fact pops its operand
     if (!is_last)
-        write_to_file(generator->fp, PUSH, EAX);
-}
-
-void generate_op_logical_and(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
-                             char *right_op_placeholder, int is_last) {
-    char *false_label = generate_label(), *done_label = generate_label();
-    char *edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
-    write_to_file(generator->fp, MOV, edx, "1");
-    write_to_file(generator->fp, CMP, reg_a, "0");
-    write_to_file(generator->fp, JE, false_label);
-    write_to_file(generator->fp, CMP, reg_b, "0");
-    write_to_file(generator->fp, JE, false_label);
-    write_to_file(generator->fp, JMP, done_label);
-    write_to_file(generator->fp, LABEL_DEF, false_label);
-    write_to_file(generator->fp, MOV, edx, "0");
-    write_to_file(generator->fp, LABEL_DEF, done_label);
-    if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
-    else
-        write_to_file(generator->fp, MOV, reg_a, edx);
-    register_handler_free_register(generator->reg_handler, generator->fp, edx);
-    free(false_label);
-    free(done_label);
-}
-
-void generate_op_logical_or(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
-                            char *right_op_placeholder, int is_last) {
-    char *done_label = generate_label();
-    char *edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
-    write_to_file(generator->fp, CMP, reg_a, "0");
-    write_to_file(generator->fp, SETNE, DL);
-    write_to_file(generator->fp, JNE, done_label);
-    write_to_file(generator->fp, CMP, reg_b, "0");
-    write_to_file(generator->fp, SETNE, DL);
-    write_to_file(generator->fp, LABEL_DEF, done_label);
-    write_to_file(generator->fp, MOVSX, edx, DL);
-    if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
-    else
-        write_to_file(generator->fp, MOV, reg_a, edx);
-    register_handler_free_register(generator->reg_handler, generator->fp, edx);
-    free(done_label);
+        generate_push(generator, EAX);
 }
 
 void generate_op_not(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
@@ -134,13 +92,13 @@ void generate_op_not(CodeGenerator *generator, char *reg_a, char *reg_b, char *l
         fprintf(stderr, "Invalid expression\n");
         exit(1);
     }
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, "0");
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETZ, DL);
     write_to_file(generator->fp, MOVSX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -149,14 +107,14 @@ void generate_op_not(CodeGenerator *generator, char *reg_a, char *reg_b, char *l
 void generate_op_equality(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                           char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, reg_b);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETE, DL);
     write_to_file(generator->fp, MOVZX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -165,14 +123,14 @@ void generate_op_equality(CodeGenerator *generator, char *reg_a, char *reg_b, ch
 void generate_op_not_equal(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                            char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, reg_b);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETNE, DL);
     write_to_file(generator->fp, MOVZX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -181,14 +139,14 @@ void generate_op_not_equal(CodeGenerator *generator, char *reg_a, char *reg_b, c
 void generate_op_greater_than(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                               char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, reg_b);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETG, DL);
     write_to_file(generator->fp, MOVZX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -197,14 +155,14 @@ void generate_op_greater_than(CodeGenerator *generator, char *reg_a, char *reg_b
 void generate_op_greater_equal(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                                char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, reg_b);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETGE, DL);
     write_to_file(generator->fp, MOVZX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -213,14 +171,14 @@ void generate_op_greater_equal(CodeGenerator *generator, char *reg_a, char *reg_
 void generate_op_lower_than(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                             char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, reg_b);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETL, DL);
     write_to_file(generator->fp, MOVZX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -229,14 +187,14 @@ void generate_op_lower_than(CodeGenerator *generator, char *reg_a, char *reg_b,
 void generate_op_lower_equal(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder,
                              char *right_op_placeholder, int is_last) {
     char *edx;
-    write_to_file(generator->fp, POP, reg_b);
-    write_to_file(generator->fp, POP, reg_a);
+    generate_pop(generator, reg_b);
+    generate_pop(generator, reg_a);
     write_to_file(generator->fp, CMP, reg_a, reg_b);
     edx = register_handler_request_register(generator->reg_handler, generator->fp, EDX);
     write_to_file(generator->fp, SETLE, DL);
     write_to_file(generator->fp, MOVZX, edx, DL);
     if (!is_last)
-        write_to_file(generator->fp, PUSH, edx);
+        generate_push(generator, edx);
     else
         write_to_file(generator->fp, MOV, reg_a, edx);
     register_handler_free_register(generator->reg_handler, generator->fp, edx);
@@ -11,8 +11,6 @@ void generate_op_division(CodeGenerator *generator, char *reg_a, char *reg_b, ch
 void generate_op_power(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
 void generate_op_modulus(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
 void generate_op_factorial(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
-void generate_op_logical_and(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
-void generate_op_logical_or(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
 void generate_op_not(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
 void generate_op_equality(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
 void generate_op_not_equal(CodeGenerator *generator, char *reg_a, char *reg_b, char *left_op_placeholder, char *right_op_placeholder, int is_last);
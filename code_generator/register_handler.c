@@ -23,6 +23,7 @@ RegisterHandler *init_register_handler() {
         hash_table_insert(reg_handler->registers_table, strdup(reg_names[i]), reg);
         reg_handler->registers_array[i] = reg;
     }
+    reg_handler->stack_depth = 0;
 
     return reg_handler;
 }
@@ -57,6 +58,7 @@ char *register_handler_request_available_register(RegisterHandler *reg_handler,
     }
     // all registers already in use, return EAX by default
     write_to_file(fp, PUSH, reg_handler->registers_array[0]->name);
+    reg_handler->stack_depth += 4;
     reg_handler->registers_array[0]->uses += 1;
     return reg->name;
 }
@@ -69,6 +71,7 @@ char *register_handler_request_register(RegisterHandler *reg_handler, FILE *fp,
     if (!reg->available) {
         // register already in use
         write_to_file(fp, PUSH, reg_name);
+        reg_handler->stack_depth += 4;
     }
     reg->uses += 1;
     reg->available = 0;
@@ -81,11 +84,16 @@ void register_handler_free_register(RegisterHandler *reg_handler, FILE *fp, char
     reg->uses -= 1;
     if (reg->uses > 0) {
         write_to_file(fp, POP, reg_name);
+        reg_handler->stack_depth -= 4;
     } else {
         reg->available = 1;
     }
 }
 
+int register_handler_is_register_in_use(RegisterHandler *reg_handler, char *reg_name) {
+    return !((Register *) hash_table_lookup(reg_handler->registers_table, reg_name))->available;
+}
+
 int register_handler_is_register_byte(char *reg_name) {
     int i;
     for (i = 0; i < ARRLEN(byte_registers); i++) {
@@ -36,6 +36,7 @@ typedef struct {
 typedef struct RegisterHandler {
     HashTable *registers_table; // all the registers as a hash table, for efficient search
     Register *registers_array[REGISTER_COUNT]; // all the registers as a list, for faster linear search
+    int stack_depth; // bytes pushed by the code of the current function since its prologue
 } RegisterHandler;
 
 RegisterHandler *init_register_handler();
@@ -67,6 +68,12 @@ char *register_handler_request_register(RegisterHandler *reg_handler, FILE *fp,
 /// \param reg_name The name of the register to free
 void register_handler_free_register(RegisterHandler *reg_handler, FILE *fp, char *reg_name);
 
+/// Returns if a register is in use.
+/// \param reg_handler The register handler struct
+/// \param reg_name
+/// \return 1 if the register holds a value, and 0 otherwise.
+int register_handler_is_register_in_use(RegisterHandler *reg_handler, char *reg_name);
+
 /// Returns if a register is an 8-bit register.
 /// \param reg_name
 /// \return 1 if the register's size is byte, and 0 otherwise.
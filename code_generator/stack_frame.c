@@ -0,0 +1,78 @@
+#include "stack_frame.h"
+#include "../logging/logging.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_SLOTS_TABLE_SIZE 31
+// offset of the first argument: above the saved EBP and the return address
+#define FIRST_ARG_OFFSET 8
+// offset of the first argument in a frame without a saved EBP: above the return address
+#define FIRST_ARG_OFFSET_WITHOUT_FRAME_POINTER 4
+
+StackFrame *init_stack_frame(char *size_name, int omits_frame_pointer) {
+    StackFrame *frame = malloc(sizeof(StackFrame));
+    if (!frame)
+        throw_memory_allocation_error(CODE_GENERATOR);
+
+    frame->size_name = strdup(size_name);
+    frame->omits_frame_pointer = omits_frame_pointer;
+    frame->slots = init_hash_table(FRAME_SLOTS_TABLE_SIZE, free);
+    frame->locals_size = 0;
+    frame->temp_count = 0;
+
+    return frame;
+}
+
+void stack_frame_dispose(StackFrame *frame) {
+    hash_table_dispose(frame->slots);
+    free(frame->size_name);
+    free(frame);
+}
+
+void stack_frame_add_slot(StackFrame *frame, char *var_name, int offset) {
+    int *slot = malloc(sizeof(int));
+    if (!slot)
+        throw_memory_allocation_error(CODE_GENERATOR);
+    *slot = offset;
+    // the table owns its keys
+    var_name = strdup(var_name);
+    if (!hash_table_insert(frame->slots, var_name, slot)) {
+        free(var_name);
+        free(slot);
+    }
+}
+
+void stack_frame_add_argument(StackFrame *frame, char *var_name, int index) {
+    stack_frame_add_slot(frame, var_name, (frame->omits_frame_pointer ? FIRST_ARG_OFFSET_WITHOUT_FRAME_POINTER
+                                                                      : FIRST_ARG_OFFSET) + 4 * index);
+}
+
+void stack_frame_add_local(StackFrame *frame, char *var_name, VarSize size) {
+    if (size == DWORD) {
+        // align to 4 bytes
+        frame->locals_size = (frame->locals_size + 3) / 4 * 4 + 4;
+    } else {
+        frame->locals_size++;
+    }
+    stack_frame_add_slot(frame, var_name, -frame->locals_size);
+}
+
+void stack_frame_add_shared_local(StackFrame *frame, char *var_name, char *owner_name) {
+    stack_frame_add_slot(frame, var_name, *(int *) hash_table_lookup(frame->slots, owner_name));
+}
+
+int stack_frame_lookup(StackFrame *frame, char *var_name, int *offset) {
+    int *slot = hash_table_lookup(frame->slots, var_name);
+    if (!slot)
+        return 0;
+    *offset = *slot;
+    return 1;
+}
+
+int stack_frame_get_temp_offset(StackFrame *frame, int temp_index) {
+    return -((frame->locals_size + 3) / 4 * 4 + 4 * (temp_index + 1));
+}
+
+int stack_frame_get_size(StackFrame *frame) {
+    return (frame->locals_size + 3) / 4 * 4 + 4 * frame->temp_count;
+}
@@ -0,0 +1,68 @@
+#ifndef INFINITY_COMPILER_STACK_FRAME_H
+#define INFINITY_COMPILER_STACK_FRAME_H
+
+#include "../hash_table/hash_table.h"
+#include "../symbol_table/symbol/symbol.h"
+
+/**
+\StackFrame
+ The storage of the arguments, local variables and temporaries of a function, addressed relative to EBP.
+ The arguments stay where the caller pushed them (above the return address), and the local variables and the
+ temporaries are below the saved EBP, reserved by the prologue with a single `sub esp, <size>`.
+ A frame that omits the frame pointer has no saved EBP, and its offsets are from the return address instead.
+ It is addressed by ESP, which moves with every push: see get_frame_address.
+*/
+typedef struct StackFrame {
+    char *size_name; // name of the constant of the size of the frame, defined after the function
+    int omits_frame_pointer; // if the frame is addressed by ESP, and the function doesn't set up EBP
+    HashTable *slots; // variable name -> offset from the saved EBP or from the return address (int *)
+    int locals_size; // bytes taken by the local variables
+    int temp_count; // temporaries used by the function, placed below the local variables
+} StackFrame;
+
+/// Initializes an empty frame
+/// \param size_name The name of the constant of the frame size (copied)
+/// \param omits_frame_pointer If the frame is addressed by ESP
+/// \return
+StackFrame *init_stack_frame(char *size_name, int omits_frame_pointer);
+
+void stack_frame_dispose(StackFrame *frame);
+
+/// Adds an argument to the frame, at the slot where the caller pushed it
+/// \param frame
+/// \param var_name
+/// \param index Index of the argument in the function signature
+void stack_frame_add_argument(StackFrame *frame, char *var_name, int index);
+
+/// Reserves a slot for a local variable below the saved EBP (or the return address). Dwords are aligned to 4 bytes,
+/// so adding the dwords before the bytes packs the frame without padding.
+/// \param frame
+/// \param var_name
+/// \param size Size of the variable
+void stack_frame_add_local(StackFrame *frame, char *var_name, VarSize size);
+
+/// Gives a local variable the slot of another local variable, whose value is not used while this one is
+/// \param frame
+/// \param var_name
+/// \param owner_name The variable that has the slot
+void stack_frame_add_shared_local(StackFrame *frame, char *var_name, char *owner_name);
+
+/// Searches a variable in the frame
+/// \param frame
+/// \param var_name
+/// \param offset Set to the offset of the variable, if found
+/// \return 1 if the variable is in the frame, 0 otherwise
+int stack_frame_lookup(StackFrame *frame, char *var_name, int *offset);
+
+/// Returns the offset of a temporary
+/// \param frame
+/// \param temp_index
+/// \return
+int stack_frame_get_temp_offset(StackFrame *frame, int temp_index);
+
+/// Returns the number of bytes the prologue reserves for the local variables and the temporaries
+/// \param frame
+/// \return Size in bytes, a multiple of 4
+int stack_frame_get_size(StackFrame *frame);
+
+#endif //INFINITY_COMPILER_STACK_FRAME_H
@@ -0,0 +1,263 @@
+#include "value_numbering.h"
+#include "../config/table_initializers.h"
+#include "../config/globals.h"
+#include "../logging/logging.h"
+#include "../io/io.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ANNOTATIONS_TABLE_SIZE 97
+
+ValueNumbering *init_value_numbering(Lexer *lexer) {
+    ValueNumbering *vn = malloc(sizeof(ValueNumbering));
+    if (!vn)
+        throw_memory_allocation_error(CODE_GENERATOR);
+
+    vn->annotations = init_hash_table(ANNOTATIONS_TABLE_SIZE, free);
+    vn->available = init_list(sizeof(AvailableValue *));
+    vn->temp_count = 0;
+    vn->max_temp_count = 0;
+    vn->eliminated_count = 0;
+    vn->lexer = lexer;
+
+    return vn;
+}
+
+void available_value_dispose(AvailableValue *value) {
+    free(value->key);
+    free(value->vars->items);
+    free(value->vars);
+    free(value);
+}
+
+void value_numbering_invalidate_all(ValueNumbering *vn) {
+    AvailableValue *value;
+    while ((value = list_pop(vn->available)) != NULL)
+        available_value_dispose(value);
+    // values don't live across basic blocks, so the temporaries can be used again
+    vn->temp_count = 0;
+}
+
+void value_numbering_invalidate_var(ValueNumbering *vn, char *var_name) {
+    int i, j;
+    AvailableValue *value;
+
+    for (i = vn->available->size - 1; i >= 0; i--) {
+        value = vn->available->items[i];
+        for (j = 0; j < value->vars->size; j++) {
+            if (strcmp(value->vars->items[j], var_name) == 0) {
+                available_value_dispose(list_remove(vn->available, i));
+                break;
+            }
+        }
+    }
+}
+
+void value_numbering_dispose(ValueNumbering *vn) {
+    value_numbering_invalidate_all(vn);
+    list_dispose(vn->available);
+    hash_table_dispose(vn->annotations);
+    free(vn);
+}
+
+int is_commutative_operator(char *op) {
+    return strcmp(op, OP_ADD) == 0 || strcmp(op, OP_MUL) == 0 ||
+           strcmp(op, OP_EQUALITY) == 0 || strcmp(op, OP_NOT_EQUAL) == 0;
+}
+
+// builds the canonical form of a computation, and collects the variables it depends on
+char *get_value_key(ExpressionNode *node, List *vars) {
+    char *key, *left_key, *right_key, *tmp;
+
+    switch (node->token->type) {
+        case VAR:
+            list_push(vars, node->token->value.var);
+            return strdup(node->token->value.var);
+        case NUMBER:
+            return alsprintf(&key, "%d", (int) node->token->value.number);
+        case OPERATOR:
+            left_key = get_value_key(node->left, vars);
+            right_key = get_value_key(node->right, vars);
+            // `b*a` is the same value as `a*b`
+            if (is_commutative_operator(node->token->value.op) && strcmp(left_key, right_key) > 0) {
+                tmp = left_key;
+                left_key = right_key;
+                right_key = tmp;
+            }
+            alsprintf(&key, "(%s%s%s)", left_key, node->token->value.op, right_key);
+            free(left_key);
+            free(right_key);
+            return key;
+        default: // placeholder
+            return strdup(node->token->value.op);
+    }
+}
+
+ValueNumberEntry *value_numbering_annotate(ValueNumbering *vn, ArithmeticToken *token, ValueNumberAction action) {
+    char *id;
+    ValueNumberEntry *entry;
+
+    alsprintf(&id, "%p", token);
+    entry = hash_table_lookup(vn->annotations, id);
+    if (entry) {
+        // the token is analyzed again - overwrite the previous annotation
+        free(id);
+    } else {
+        entry = malloc(sizeof(ValueNumberEntry));
+        if (!entry)
+            throw_memory_allocation_error(CODE_GENERATOR);
+        hash_table_insert(vn->annotations, id, entry);
+    }
+    entry->action = action;
+    entry->temp_index = -1;
+    entry->stored = 0;
+    entry->source = NULL;
+
+    return entry;
+}
+
+ValueNumberEntry *value_numbering_lookup(ValueNumbering *vn, ExpressionNode *node) {
+    char *id;
+    ValueNumberEntry *entry;
+
+    alsprintf(&id, "%p", node->token);
+    entry = hash_table_lookup(vn->annotations, id);
+    free(id);
+    return entry;
+}
+
+void value_numbering_scan_condition(ValueNumbering *vn, ExpressionNode *node, int always_evaluated);
+
+/// Scans an expression sub-tree in the order the code generator evaluates it.
+/// \param always_evaluated Whether the sub-tree is evaluated whenever the statement is executed.
+/// Only such values can be reused later.
+void value_numbering_scan_value(ValueNumbering *vn, ExpressionNode *node, int always_evaluated) {
+    int i;
+    char *key;
+    List *vars;
+    AvailableValue *value;
+    ValueNumberEntry *entry;
+
+    if (node->token->type != OPERATOR)
+        return;
+
+    vars = init_list(sizeof(char *));
+    key = get_value_key(node, vars);
+    for (i = 0; i < vn->available->size; i++) {
+        value = vn->available->items[i];
+        if (strcmp(value->key, key) == 0) {
+            // computed before - reuse it
+            if (value->entry->temp_index == -1) {
+                value->entry->temp_index = vn->temp_count++;
+                vn->max_temp_count = MAX(vn->max_temp_count, vn->temp_count);
+            }
+            entry = value_numbering_annotate(vn, node->token, VN_REUSE);
+            entry->source = value->entry;
+            free(key);
+            free(vars->items);
+            free(vars);
+            return;
+        }
+    }
+
+    if (expression_node_is_operator(node, OP_LOGICAL_AND) || expression_node_is_operator(node, OP_LOGICAL_OR)) {
+        value_numbering_scan_condition(vn, node, always_evaluated);
+    } else {
+        value_numbering_scan_value(vn, node->left, always_evaluated);
+        value_numbering_scan_value(vn, node->right, always_evaluated);
+    }
+
+    if (always_evaluated) {
+        value = malloc(sizeof(AvailableValue));
+        if (!value)
+            throw_memory_allocation_error(CODE_GENERATOR);
+        value->key = key;
+        value->vars = vars;
+        value->entry = value_numbering_annotate(vn, node->token, VN_SAVE);
+        list_push(vn->available, value);
+    } else {
+        free(key);
+        free(vars->items);
+        free(vars);
+    }
+}
+
+// scans a sub-tree that is generated as jumps (see generate_condition_node)
+void value_numbering_scan_condition(ValueNumbering *vn, ExpressionNode *node, int always_evaluated) {
+    if (expression_node_is_operator(node, OP_LOGICAL_AND) || expression_node_is_operator(node, OP_LOGICAL_OR)) {
+        value_numbering_scan_condition(vn, node->left, always_evaluated);
+        // the right operand is skipped when the left one decides the result
+        value_numbering_scan_condition(vn, node->right, 0);
+    } else if (expression_node_is_operator(node, OP_NOT)) {
+        value_numbering_scan_condition(vn, node->right, always_evaluated);
+    } else if (node->token->type == OPERATOR && is_relational_operator(node->token->value.op)) {
+        value_numbering_scan_value(vn, node->left, always_evaluated);
+        value_numbering_scan_value(vn, node->right, always_evaluated);
+    } else {
+        value_numbering_scan_value(vn, node, always_evaluated);
+    }
+}
+
+void value_numbering_scan_expression(ValueNumbering *vn, Expression *expr, int as_condition) {
+    ExpressionNode *root;
+
+    if (!expr->contains_variables || expr->value->type == TYPE_STRING)
+        return;
+    root = expression_tree_from_postfix(expr->tokens, vn->lexer);
+    as_condition ? value_numbering_scan_condition(vn, root, 1) : value_numbering_scan_value(vn, root, 1);
+    expression_tree_dispose(root);
+}
+
+void value_numbering_analyze_block(ValueNumbering *vn, List *block) {
+    int i, j;
+    AstNode *node;
+    List *args;
+
+    value_numbering_invalidate_all(vn);
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                value_numbering_scan_expression(vn, &node->data.variable_declaration.value->data.expression, 0);
+                value_numbering_invalidate_var(vn, node->data.variable_declaration.var->name);
+                break;
+            case AST_ASSIGNMENT:
+                value_numbering_scan_expression(vn, &node->data.assignment.expression->data.expression, 0);
+                value_numbering_invalidate_var(vn, node->data.assignment.dst_variable->value);
+                break;
+            case AST_SWAP_STATEMENT:
+                value_numbering_invalidate_var(vn, node->data.swap_statement.var_a->value);
+                value_numbering_invalidate_var(vn, node->data.swap_statement.var_b->value);
+                break;
+            case AST_FUNCTION_CALL:
+                args = node->data.function_call.args;
+                if (hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name)) {
+                    // builtin functions only read their arguments
+                    for (j = 0; j < args->size; j++)
+                        value_numbering_scan_expression(vn, &((AstNode *) args->items[j])->data.expression, 1);
+                } else {
+                    // arguments are pushed from last to first, and the function may change any variable
+                    for (j = args->size - 1; j >= 0; j--)
+                        value_numbering_scan_expression(vn, &((AstNode *) args->items[j])->data.expression, 0);
+                    value_numbering_invalidate_all(vn);
+                }
+                break;
+            case AST_IF_STATEMENT:
+                // the condition ends the basic block
+                value_numbering_scan_expression(vn, &node->data.if_statement.condition->data.expression, 1);
+                value_numbering_invalidate_all(vn);
+                break;
+            case AST_RETURN_STATEMENT:
+                if (node->data.return_statement.value_expr->data.expression.value->type != TYPE_VOID)
+                    value_numbering_scan_expression(vn, &node->data.return_statement.value_expr->data.expression, 0);
+                value_numbering_invalidate_all(vn);
+                break;
+            default:
+                // loops and function definitions start new blocks
+                value_numbering_invalidate_all(vn);
+                break;
+        }
+    }
+    value_numbering_invalidate_all(vn);
+}
@@ -0,0 +1,68 @@
+#ifndef INFINITY_COMPILER_VALUE_NUMBERING_H
+#define INFINITY_COMPILER_VALUE_NUMBERING_H
+
+#include "../hash_table/hash_table.h"
+#include "../list/list.h"
+#include "../ast/ast.h"
+#include "../expression_evaluator/expression_tree.h"
+#include "../lexer/lexer.h"
+
+typedef enum ValueNumberAction {
+    VN_SAVE,  // the computed value is stored in a temporary for later use
+    VN_REUSE, // the value is loaded from the temporary instead of being computed
+} ValueNumberAction;
+
+/**
+\ValueNumberEntry
+ Annotation of an operator token, made by the value numbering analysis and used by the code generator.
+*/
+typedef struct ValueNumberEntry {
+    ValueNumberAction action;
+    int temp_index; // index of the temporary holding the value, -1 if the value is never reused
+    int stored; // VN_SAVE: whether the store to the temporary was already generated
+    struct ValueNumberEntry *source; // VN_REUSE: the entry that computed the value
+} ValueNumberEntry;
+
+/**
+\AvailableValue
+ A value computed earlier in the current basic block, during the analysis.
+*/
+typedef struct AvailableValue {
+    char *key; // canonical form of the computation, like "(a*b)"
+    List *vars; // names of the variables the value depends on
+    ValueNumberEntry *entry;
+} AvailableValue;
+
+/**
+\ValueNumbering
+ Local value numbering: finds computations that are repeated inside a basic block, so they are computed once,
+ stored in a temporary, and reused.
+*/
+typedef struct ValueNumbering {
+    HashTable *annotations; // operator token address -> ValueNumberEntry
+    List *available; // list of AvailableValue, valid for the analyzed basic block
+    int temp_count; // temporaries used by the current basic block
+    int max_temp_count; // temporaries needed by the current function
+    int eliminated_count; // number of computations replaced by a temporary
+
+    Lexer *lexer; // for error reporting
+} ValueNumbering;
+
+ValueNumbering *init_value_numbering(Lexer *lexer);
+
+void value_numbering_dispose(ValueNumbering *vn);
+
+/// Analyzes a list of statements and annotates the repeated computations in it.
+/// Each maximal run of straight-line statements is a basic block, and values never live across blocks.
+/// Nested blocks (bodies of ifs, loops and functions) are analyzed when they are generated.
+/// \param vn
+/// \param block List of statements
+void value_numbering_analyze_block(ValueNumbering *vn, List *block);
+
+/// Returns the annotation of an operator node, if it has one
+/// \param vn
+/// \param node
+/// \return The annotation or NULL
+ValueNumberEntry *value_numbering_lookup(ValueNumbering *vn, ExpressionNode *node);
+
+#endif //INFINITY_COMPILER_VALUE_NUMBERING_H
@@ -6,6 +6,9 @@
 #include "../io/io.h"
 #include "../config/globals.h"
 #include "../code_generator/code_generator.h"
+#include "../optimizer/optimizer.h"
+#include "../optimizer/compile_time_evaluation.h"
+#include "../options_parser/options_parser.h"
 #include "../config/console_colors.h"
 
 #include <stdio.h>
@@ -17,7 +20,9 @@ void compiler_compile(char *src, char *output_path) {
     Parser *parser;
     AstNode *root;
     SemanticAnalyzer *analyzer;
+    Optimizer *optimizer;
     CodeGenerator *generator;
+    Evaluation evaluation;
     int error_count;
     init_globals();
     lexer = init_lexer(src);
@@ -33,9 +38,19 @@ void compiler_compile(char *src, char *output_path) {
         print_unicode(UNI_RED_B, error_count < 2 ? L" ~(>_<。)＼\n" : error_count < 5 ? L" ⊙﹏⊙∥\n" : L" X﹏X\n");
         exit(1);
     }
+    // optimize tree
+    optimizer = init_optimizer(root, analyzer->starting_point, analyzer->table, lexer);
+    optimizer_optimize(optimizer);
     // generate code
     generator = init_code_generator(analyzer->table, root, analyzer->starting_point, output_path, lexer);
-    code_generator_generate(generator);
+    if (compiler_options.partial_evaluation && evaluate_program(optimizer, &evaluation)) {
+        // the program takes no input, so its output is known
+        code_generator_generate_precomputed(generator, evaluation.output, evaluation.output_length,
+                                            evaluation.exit_code);
+        free(evaluation.output);
+    } else {
+        code_generator_generate(generator);
+    }
 
 //     Token *tok;
 //     while ((tok = lexer_next_token(lexer))->type != EOF_TOKEN)
@@ -45,6 +60,7 @@ void compiler_compile(char *src, char *output_path) {
 
     parser_dispose(parser);
     semantic_analyzer_dispose(analyzer);
+    optimizer_dispose(optimizer);
     dispose_code_generator(generator);
     clean_globals();
 }
@@ -1,5 +1,8 @@
 ; ** Helper Procedures **
+; Print, PrintNewLine, PrintChar, PrintInt and FlushOutput take their arguments in ECX and EDX, and may change
+; EAX, ECX and EDX. Power, Fact and Exit take their arguments on the stack.
 Exit:
+    call FlushOutput
     mov ebp, esp
     mov ebx, [ebp+4]
     mov eax, 1
@@ -7,9 +10,8 @@ Exit:
 ; Exit
 
 ExitZeroDiv:
-    movzx eax, byte [zero_div_msg]
-    push eax
-    push zero_div_msg+1
+    movzx edx, byte [zero_div_msg]
+    mov ecx, zero_div_msg+1
     call Print
     push 1
     call Exit
@@ -73,82 +75,116 @@ f_done:
 	ret 4
 ; Fact
 
+FlushOutput:
+    mov edx, [out_stream_len]
+    cmp edx, 0
+    je flush_done
+    push ebx
+    mov eax, 4
+    mov ebx, 1
+    mov ecx, out_stream
+    int 0x80
+    pop ebx
+    mov dword [out_stream_len], 0
+flush_done:
+    ret
+; FlushOutput
+
+; ECX - text, EDX - length
 Print:
-    push ebp
-    mov ebp, esp
-    pusha
+    mov eax, [out_stream_len]
+    add eax, edx
+    cmp eax, out_stream_size
+    ja print_flush
+print_buffered:
+    ; EAX - length of the buffer after the text is added
+    push esi
+    push edi
+    mov esi, ecx
+    mov edi, out_stream
+    add edi, [out_stream_len]
+    mov [out_stream_len], eax
+    mov ecx, edx
+    rep movsb
+    pop edi
+    pop esi
+    ret
+print_flush:
+    push ecx
+    push edx
+    call FlushOutput
+    pop edx
+    pop ecx
+    mov eax, edx
+    cmp edx, out_stream_size
+    jbe print_buffered
+    ; text longer than the buffer is written right away
+    push ebx
     mov eax, 4
     mov ebx, 1
-    mov ecx, [ebp+8]
-    mov edx, [ebp+12]
     int 0x80
-    popa
-    pop ebp
-    ret 8
+    pop ebx
+    ret
 ; Print
 
 PrintNewLine:
-	pusha
-	mov eax, 4
-    mov ebx, 1
     mov ecx, new_line_chr
     mov edx, 1
-    int 0x80
-	popa
-	ret
+    jmp Print
 ; PrintNewLine
 
+; ECX - character
 PrintChar:
-    push ebp
-    mov ebp, esp
-    push eax
-    mov eax, [ebp+8]
-    mov byte [char_buf], al
-    push 1
-    push char_buf
-    call Print
-    pop eax
-    pop ebp
-    ret 4
+    mov [char_buf], cl
+    mov ecx, char_buf
+    mov edx, 1
+    jmp Print
 ; PrintChar
 
+; ECX - number
+; converts two digits at a time: n / 100 is computed as (n * ceil(2^37 / 100)) >> 37, which is exact for every
+; 32-bit n, and the remainder is looked up in digit_pairs ("00", "01", ..., "99")
 PrintInt:
-    push ebp
-    mov ebp, esp
-    pusha
-    mov eax, [ebp+8]
-    mov esi, out_buf+out_buf_len-1
-    mov ebx, 10
-    mov byte [esi], '0'
-    mov edi, 0
-    cmp eax, 0
-    je print_num
-    inc esi
-    cmp eax, 0
-    jge conv_loop
-    neg eax
-    mov edi, 1
-conv_loop:
+    push ebx
+    push ecx
+    mov ebx, out_buf+out_buf_len
+    cmp ecx, 0
+    jge int_pairs
+    neg ecx
+int_pairs:
+    cmp ecx, 100
+    jb int_last_digits
+    mov eax, 0x51EB851F
+    mul ecx
+    shr edx, 5
+    imul eax, edx, 100
+    sub ecx, eax
+    movzx eax, word [digit_pairs+ecx*2]
+    sub ebx, 2
+    mov [ebx], ax
+    mov ecx, edx
+    jmp int_pairs
+int_last_digits:
+    cmp ecx, 10
+    jb int_last_digit
+    movzx eax, word [digit_pairs+ecx*2]
+    sub ebx, 2
+    mov [ebx], ax
+    jmp int_sign
+int_last_digit:
+    add ecx, '0'
+    dec ebx
+    mov [ebx], cl
+int_sign:
+    pop eax
     cmp eax, 0
-    je end_conv
-    dec esi
-    xor edx, edx
-    div ebx
-    add edx, '0'
-    mov [esi], dl
-    jmp conv_loop
-end_conv:
-    cmp edi, 0
-    je print_num
-    dec esi
-    mov byte [esi], '-'
-print_num:
+    jge int_print
+    dec ebx
+    mov byte [ebx], '-'
+int_print:
+    mov ecx, ebx
     mov edx, out_buf+out_buf_len
-    sub edx, esi
-    push edx
-    push esi
-    call Print
-    popa
-    pop ebp
-    ret 4
-; PrintInt
\ No newline at end of file
+    sub edx, ebx
+    pop ebx
+    jmp Print
+; PrintInt
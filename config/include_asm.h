@@ -0,0 +1,8 @@
+#ifndef INFINITY_COMPILER_INCLUDE_ASM_H
+#define INFINITY_COMPILER_INCLUDE_ASM_H
+
+/// The helper procedures of config/include.asm, embedded in the compiler at build time (see cmake/embed_file.cmake),
+/// as a null-terminated string
+extern const char include_asm[];
+
+#endif //INFINITY_COMPILER_INCLUDE_ASM_H
@@ -443,8 +443,6 @@ void init_operator_to_generator_map() {
             OP_POW,
             OP_MOD,
             OP_FACT,
-            OP_LOGICAL_AND,
-            OP_LOGICAL_OR,
             OP_NOT,
             OP_EQUALITY,
             OP_NOT_EQUAL,
@@ -461,8 +459,6 @@ void init_operator_to_generator_map() {
             generate_op_power,
             generate_op_modulus,
             generate_op_factorial,
-            generate_op_logical_and,
-            generate_op_logical_or,
             generate_op_not,
             generate_op_equality,
             generate_op_not_equal,
@@ -0,0 +1,65 @@
+#include "expression_tree.h"
+#include "../logging/logging.h"
+#include <stdlib.h>
+#include <string.h>
+
+ExpressionNode *init_expression_node(ArithmeticToken *token, ExpressionNode *left, ExpressionNode *right) {
+    ExpressionNode *node = malloc(sizeof(ExpressionNode));
+    if (!node)
+        throw_memory_allocation_error(CODE_GENERATOR);
+    node->token = token;
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+void expression_tree_dispose(ExpressionNode *root) {
+    if (!root)
+        return;
+    expression_tree_dispose(root->left);
+    expression_tree_dispose(root->right);
+    free(root);
+}
+
+ExpressionNode *expression_tree_from_postfix(List *postfix, Lexer *lexer) {
+    int i;
+    List *stack;
+    ArithmeticToken *curr_token;
+    ExpressionNode *left, *right, *root;
+
+    stack = init_list(sizeof(ExpressionNode *));
+    for (i = 0; i < postfix->size; i++) {
+        curr_token = postfix->items[i];
+
+        if (curr_token->type == OPERATOR) {
+            right = list_pop(stack);
+            left = list_pop(stack);
+            if (!right || !left) {
+                log_exception_with_trace(CODE_GENERATOR, lexer, curr_token->original_tok->line,
+                                         curr_token->original_tok->column, curr_token->original_tok->length,
+                                         "Missing operands.");
+            }
+            list_push(stack, init_expression_node(curr_token, left, right));
+        } else {
+            list_push(stack, init_expression_node(curr_token, NULL, NULL));
+        }
+    }
+    root = list_pop(stack);
+    if (!root || !list_is_empty(stack)) {
+        log_exception(CODE_GENERATOR, "Invalid expression");
+    }
+
+    free(stack->items);
+    free(stack);
+    return root;
+}
+
+int expression_node_is_operator(ExpressionNode *node, char *op) {
+    return node->token->type == OPERATOR && (!op || strcmp(node->token->value.op, op) == 0);
+}
+
+int is_relational_operator(char *op) {
+    return strcmp(op, OP_EQUALITY) == 0 || strcmp(op, OP_NOT_EQUAL) == 0 ||
+           strcmp(op, OP_GRATER_THAN) == 0 || strcmp(op, OP_GRATER_EQUAL) == 0 ||
+           strcmp(op, OP_LOWER_THAN) == 0 || strcmp(op, OP_LOWER_EQUAL) == 0;
+}
@@ -0,0 +1,40 @@
+#ifndef INFINITY_COMPILER_EXPRESSION_TREE_H
+#define INFINITY_COMPILER_EXPRESSION_TREE_H
+
+#include "expression_evaluator.h"
+
+/**
+\ExpressionNode
+ A node in a binary tree representation of a postfix expression.
+ Leaves hold operands (variables, numbers or placeholders), inner nodes hold operators.
+*/
+typedef struct ExpressionNode {
+    ArithmeticToken *token;
+    struct ExpressionNode *left;
+    struct ExpressionNode *right;
+} ExpressionNode;
+
+ExpressionNode *init_expression_node(ArithmeticToken *token, ExpressionNode *left, ExpressionNode *right);
+
+/// Frees the nodes of an expression tree. The tokens themselves are owned by the expression and are not freed.
+/// \param root
+void expression_tree_dispose(ExpressionNode *root);
+
+/// Builds an expression tree from an expression in postfix notation.
+/// \param postfix List of ArithmeticToken(s), in postfix
+/// \param lexer For error reporting
+/// \return The root of the tree
+ExpressionNode *expression_tree_from_postfix(List *postfix, Lexer *lexer);
+
+/// Whether a node is an operator node
+/// \param node
+/// \param op If not NULL, checks that the node's operator is `op`
+/// \return Boolean
+int expression_node_is_operator(ExpressionNode *node, char *op);
+
+/// Whether an operator is a comparison operator (==, !=, >, >=, <, <=)
+/// \param op
+/// \return Boolean
+int is_relational_operator(char *op);
+
+#endif //INFINITY_COMPILER_EXPRESSION_TREE_H
@@ -81,11 +81,32 @@ void list_insert(List *list, int idx, void *item) {
         list->items = realloc(list->items, list->size * list->item_size);
     }
 
-    memmove(&list->items[idx + 1], &list->items[idx], (list->size - idx) * list->item_size);
+    memmove(&list->items[idx + 1], &list->items[idx], (list->size - idx - 1) * list->item_size);
 
     list->items[idx] = item;
 }
 
+void *list_remove(List *list, int idx) {
+    void *item;
+    if (idx > (int) list->size - 1 || idx < 0)
+        return NULL;
+
+    item = list->items[idx];
+    memmove(&list->items[idx], &list->items[idx + 1], (list->size - idx - 1) * list->item_size);
+    list->size--;
+
+    return item;
+}
+
+int list_contains(List *list, void *item) {
+    int i;
+    for (i = 0; i < list->size; i++) {
+        if (list->items[i] == item)
+            return 1;
+    }
+    return 0;
+}
+
 void list_print_integers(const List *list) {
     printf("[");
     for (int i = 0; i < list->size; i++) {
@@ -49,6 +49,18 @@ void list_clear(List *list, int free_content);
 /// \param item The item to insert.
 void list_insert(List *list, int idx, void *item);
 
+/// Removes an item at an index, keeping the order of the other items.
+/// \param list
+/// \param idx Index of the item to remove.
+/// \return The removed item, or NULL if the index is out of range.
+void *list_remove(List *list, int idx);
+
+/// Checks if an item is in a list (compares the pointers)
+/// \param list
+/// \param item
+/// \return 1 if the item is in the list, 0 otherwise.
+int list_contains(List *list, void *item);
+
 void list_print_integers(const List *list);
 
 /// Print the contents of a list
@@ -2,6 +2,7 @@
 #include "../io/io.h"
 #include "../config/globals.h"
 #include "../config/console_colors.h"
+#include "../options_parser/options_parser.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -21,6 +22,8 @@ char *caller_type_to_str(Caller caller) {
             return "Analyzer";
         case CODE_GENERATOR:
             return "Code Generator";
+        case OPTIMIZER:
+            return "Optimizer";
         default:
             return "Unknown";
     }
@@ -150,6 +153,16 @@ void log_info(Caller caller, const char *format, ...) {
     va_end(args);
 }
 
+// logs only when the compiler runs in verbose mode
+void log_verbose(Caller caller, const char *format, ...) {
+    va_list args;
+    if (!compiler_options.verbose)
+        return;
+    va_start(args, format);
+    __log_msg(caller, INFO, format, args);
+    va_end(args);
+}
+
 void log_warning(Caller caller, const char *format, ...) {
     va_list args;
     va_start(args, format);
@@ -10,6 +10,7 @@ typedef enum Caller {
     PARSER,
     SEMANTIC_ANALYZER,
     CODE_GENERATOR,
+    OPTIMIZER,
 } Caller;
 
 typedef enum LogLevel {
@@ -36,6 +37,8 @@ void log_debug(Caller caller, const char *format, ...);
 
 void log_info(Caller caller, const char *format, ...);
 
+void log_verbose(Caller caller, const char *format, ...);
+
 void log_warning(Caller caller, const char *format, ...);
 
 void log_error(Caller caller, const char *format, ...);
@@ -4,6 +4,7 @@
 #include "config/globals.h"
 #include "compiler/compiler.h"
 #include "io/io.h"
+#include "options_parser/options_parser.h"
 
 /*
  * TODO: handle duplicate variables on different scopes (x0, x1, ...)
@@ -12,11 +13,13 @@
 int main(int argc, char *argv[]) {
     char *output_path;
 
+    argc = parse_options(argc, argv);
     // check that target file is specified
     if (argc < 2) {
         printf("Please provide target file path as a command line argument.\n"
-               "Usage: %s target_file_path.%s [output_file_path.%s]\n",
+               "Usage: %s [options] target_file_path.%s [output_file_path.%s]\n",
                get_file_name(argv[0]), INPUT_EXTENSION, OUTPUT_EXTENSION);
+        print_options_usage();
         exit(0);
     }
     // check file extension
@@ -0,0 +1,577 @@
+#include "compile_time_evaluation.h"
+#include "store_elimination.h"
+#include "../config/table_initializers.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include "../semantic_analyzer/semantic_analyzer.h"
+#include "../logging/logging.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <math.h>
+
+// whether a block has a statement that has a side effect, other than calling a function that is not known to be impure
+int block_has_side_effects(Optimizer *optimizer, List *block, List *impure_functions) {
+    int i;
+    AstNode *node;
+    char *func_name;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                if (optimizer_is_global_var(optimizer, node->data.assignment.dst_variable->value))
+                    return 1;
+                break;
+            case AST_SWAP_STATEMENT:
+                if (optimizer_is_global_var(optimizer, node->data.swap_statement.var_a->value) ||
+                    optimizer_is_global_var(optimizer, node->data.swap_statement.var_b->value))
+                    return 1;
+                break;
+            case AST_FUNCTION_CALL:
+                func_name = node->data.function_call.func_name;
+                // print, println and exit
+                if (hash_table_lookup(builtin_function_to_generator_map, func_name) ||
+                    name_set_contains(impure_functions, func_name))
+                    return 1;
+                break;
+            case AST_IF_STATEMENT:
+                if (block_has_side_effects(optimizer, node->data.if_statement.body_node, impure_functions) ||
+                    block_has_side_effects(optimizer, node->data.if_statement.else_node, impure_functions))
+                    return 1;
+                break;
+            case AST_LOOP:
+                if ((node->data.loop.loop_counter_name &&
+                     optimizer_is_global_var(optimizer, node->data.loop.loop_counter_name)) ||
+                    block_has_side_effects(optimizer, node->data.loop.body, impure_functions))
+                    return 1;
+                break;
+            case AST_WHILE_LOOP:
+                if (block_has_side_effects(optimizer, node->data.while_loop.body, impure_functions))
+                    return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+List *find_impure_functions(Optimizer *optimizer) {
+    int i, changed = 1;
+    AstNode *node;
+    List *functions = optimizer->root->data.compound.children;
+    List *impure_functions = init_list(sizeof(char *));
+
+    // a function is impure if it has a side effect itself, or calls an impure function.
+    // repeat until no more functions are found, so impurity spreads through the whole call graph
+    while (changed) {
+        changed = 0;
+        for (i = 0; i < functions->size; i++) {
+            node = functions->items[i];
+            if (node->type != AST_FUNCTION_DEFINITION ||
+                name_set_contains(impure_functions, node->data.function_definition.func_name))
+                continue;
+            if (block_has_side_effects(optimizer, node->data.function_definition.body, impure_functions)) {
+                name_set_add(impure_functions, node->data.function_definition.func_name);
+                changed = 1;
+            }
+        }
+    }
+    return impure_functions;
+}
+
+// whether a value can be held by a register of the generated code
+int is_int_value(double value) {
+    return value == (int) value && value >= INT_MIN && value <= INT_MAX;
+}
+
+int apply_operator_at_compile_time(char *op, double a, double b, char *left_placeholder, char *right_placeholder,
+                                   double *result) {
+    double (*applier_func)(double, double, char *, char *);
+
+    if (strcmp(op, OP_DIV) == 0 || strcmp(op, OP_MOD) == 0) {
+        // the generated code exits on a division by zero, and does not extend the sign of the dividend
+        if (b == 0 || a < 0)
+            return 0;
+        *result = strcmp(op, OP_DIV) == 0 ? (int) a / (int) b : (int) a % (int) b;
+        return 1;
+    }
+    if (strcmp(op, OP_POW) == 0 && b < 0)
+        return 0;
+    if (strcmp(op, OP_FACT) == 0 && a <= 1) {
+        *result = 1;
+        return 1;
+    }
+    applier_func = hash_table_lookup(operator_to_applier_function_map, op);
+    if (!applier_func)
+        return 0;
+    *result = applier_func(a, b, left_placeholder, right_placeholder);
+    // the generated code overflows (or truncates) where the evaluation does not
+    return is_int_value(*result);
+}
+
+// finds a variable in the frame of the current function, or in the global variables
+EvaluationVariable *lookup_variable(Evaluation *evaluation, HashTable *frame, char *var_name) {
+    EvaluationVariable *var = hash_table_lookup(frame, var_name);
+
+    if (!var && evaluation->globals)
+        var = hash_table_lookup(evaluation->globals, var_name);
+    return var;
+}
+
+// stores a value in a variable, as the generated code does
+void store_variable(EvaluationVariable *var, double value) {
+    // bytes are loaded with sign extension
+    var->value = var->type == TYPE_BOOL || var->type == TYPE_CHAR ? (signed char) (int) value : value;
+}
+
+// declares a variable in a frame (or sets it, if it is already declared)
+void declare_variable(HashTable *frame, char *var_name, DataType type, double value) {
+    EvaluationVariable *var = hash_table_lookup(frame, var_name);
+
+    if (!var) {
+        var = malloc(sizeof(EvaluationVariable));
+        if (!var)
+            throw_memory_allocation_error(OPTIMIZER);
+        hash_table_insert(frame, strdup(var_name), var);
+    }
+    var->type = type;
+    store_variable(var, value);
+}
+
+int evaluate_expression_at_compile_time(Evaluation *evaluation, Expression *expr, HashTable *frame, double *result) {
+    int i, size = 0, success = 1;
+    ArithmeticToken *token;
+    EvaluationVariable *var;
+    double *stack;
+    char **placeholders;
+
+    if (expr->value->type == TYPE_STRING || expr->value->type == TYPE_VOID)
+        return 0;
+    if (!expr->contains_variables) {
+        *result = (int) expr->value->value.double_value;
+        return 1;
+    }
+
+    stack = malloc(expr->tokens->size * sizeof(double));
+    placeholders = malloc(expr->tokens->size * sizeof(char *));
+    if (!stack || !placeholders)
+        throw_memory_allocation_error(OPTIMIZER);
+    for (i = 0; i < expr->tokens->size && success; i++) {
+        token = expr->tokens->items[i];
+
+        switch (token->type) {
+            case NUMBER:
+                placeholders[size] = "";
+                stack[size++] = (int) token->value.number;
+                break;
+            case PLACEHOLDER:
+                placeholders[size] = token->value.op;
+                stack[size++] = 0;
+                break;
+            case VAR:
+                // when evaluating a single call, global variables are not known
+                var = lookup_variable(evaluation, frame, token->value.var);
+                if (!var || var->type == TYPE_STRING) {
+                    success = 0;
+                    break;
+                }
+                placeholders[size] = "";
+                stack[size++] = var->value;
+                break;
+            case OPERATOR:
+                if (size < 2) {
+                    success = 0;
+                    break;
+                }
+                size--;
+                // `and` and `or` don't evaluate their right operand when the left one decides the result,
+                // so an operation that can't be evaluated there is marked with NaN, and fails only if it is used
+                if (strcmp(token->value.op, OP_LOGICAL_AND) == 0 && !isnan(stack[size - 1]) &&
+                    stack[size - 1] == 0) {
+                    stack[size - 1] = 0;
+                } else if (strcmp(token->value.op, OP_LOGICAL_OR) == 0 && !isnan(stack[size - 1]) &&
+                           stack[size - 1] != 0) {
+                    stack[size - 1] = 1;
+                } else if (isnan(stack[size - 1]) || isnan(stack[size]) ||
+                           !apply_operator_at_compile_time(token->value.op, stack[size - 1], stack[size],
+                                                           placeholders[size - 1], placeholders[size],
+                                                           &stack[size - 1])) {
+                    stack[size - 1] = NAN;
+                }
+                placeholders[size - 1] = "";
+                break;
+            default:
+                success = 0;
+                break;
+        }
+    }
+    success = success && size == 1 && !isnan(stack[0]);
+    if (success)
+        *result = stack[0];
+    free(stack);
+    free(placeholders);
+    return success;
+}
+
+// counts a step of the evaluation, and returns false if the evaluation ran out of steps
+int evaluation_step(Evaluation *evaluation) {
+    return ++evaluation->steps <= evaluation->max_steps;
+}
+
+// appends text to the output of the program, and returns false if the output is too long
+int evaluation_write(Evaluation *evaluation, char *text, int length) {
+    if (evaluation->output_length + length > PROGRAM_EVALUATION_MAX_OUTPUT)
+        return 0;
+    if (evaluation->output_length + length > evaluation->output_capacity) {
+        evaluation->output_capacity = 2 * (evaluation->output_length + length);
+        evaluation->output = realloc(evaluation->output, evaluation->output_capacity);
+        if (!evaluation->output)
+            throw_memory_allocation_error(OPTIMIZER);
+    }
+    memcpy(evaluation->output + evaluation->output_length, text, length);
+    evaluation->output_length += length;
+    return 1;
+}
+
+// writes the arguments of print to the output, the way generate_print prints them
+int evaluate_print(Evaluation *evaluation, AstNode *node, HashTable *frame) {
+    int i;
+    char buf[12];
+    double value;
+    Expression *arg_expr;
+    ArithmeticToken *last_token;
+    StringSymbol *str_sym;
+
+    for (i = 0; i < node->data.function_call.args->size; i++) {
+        arg_expr = &((AstNode *) node->data.function_call.args->items[i])->data.expression;
+
+        if (arg_expr->value->type == TYPE_STRING) {
+            // string variables are not evaluated
+            if (arg_expr->contains_variables)
+                return 0;
+            str_sym = string_repository_lookup(evaluation->optimizer->symbol_table->str_repo,
+                                               arg_expr->value->value.string_value);
+            if (!evaluation_write(evaluation, str_sym->value, (int) str_sym->length))
+                return 0;
+            continue;
+        }
+        if (!evaluate_expression_at_compile_time(evaluation, arg_expr, frame, &value))
+            return 0;
+        last_token = list_get_last(arg_expr->tokens);
+        if (arg_expr->contains_variables && last_token->type == NUMBER) {
+            return 0;
+        } else if (arg_expr->contains_variables && strstr("andornot>=<=!=", last_token->value.op)) {
+            // boolean
+            if (!(value != 0 ? evaluation_write(evaluation, "true", 4) : evaluation_write(evaluation, "false", 5)))
+                return 0;
+        } else if (arg_expr->tokens->size == 1 && last_token->original_tok->type == CHAR) {
+            // char
+            if (!evaluation_write(evaluation, last_token->original_tok->value, 1))
+                return 0;
+        } else {
+            // int
+            if (!evaluation_write(evaluation, buf, sprintf(buf, "%d", (int) value)))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+// executes a call to print, println or exit
+EvaluationResult evaluate_builtin_call(Evaluation *evaluation, AstNode *node, HashTable *frame) {
+    double exit_code;
+    char *func_name = node->data.function_call.func_name;
+
+    if (!evaluation->globals)
+        return EVALUATION_FAILED;
+    if (strcmp(func_name, EXIT_FUNC) == 0) {
+        if (!evaluate_expression_at_compile_time(
+                evaluation, &((AstNode *) node->data.function_call.args->items[0])->data.expression, frame,
+                &exit_code))
+            return EVALUATION_FAILED;
+        evaluation->exit_code = (int) exit_code;
+        return EVALUATION_EXITED;
+    }
+    if (!evaluate_print(evaluation, node, frame))
+        return EVALUATION_FAILED;
+    // the new line character of println
+    if (strcmp(func_name, PRINTLN_FUNC) == 0 && !evaluation_write(evaluation, "\r", 1))
+        return EVALUATION_FAILED;
+    return EVALUATION_COMPLETED;
+}
+
+EvaluationResult evaluate_loop_at_compile_time(Evaluation *evaluation, AstNode *node, HashTable *frame) {
+    double start, end;
+    char *counter_name = node->data.loop.loop_counter_name;
+    EvaluationVariable *counter;
+    EvaluationResult result;
+
+    if (!evaluate_expression_at_compile_time(evaluation, node->data.loop.end, frame, &end))
+        return EVALUATION_FAILED;
+    if (!counter_name) {
+        // the count is in ECX, and the body can't change it
+        for (; end > 0; end--) {
+            if (!evaluation_step(evaluation))
+                return EVALUATION_FAILED;
+            if ((result = evaluate_block_at_compile_time(evaluation, node->data.loop.body, frame)) !=
+                EVALUATION_COMPLETED)
+                return result;
+        }
+        return EVALUATION_COMPLETED;
+    }
+
+    if (!evaluate_expression_at_compile_time(evaluation, node->data.loop.start, frame, &start))
+        return EVALUATION_FAILED;
+    if (!(counter = lookup_variable(evaluation, frame, counter_name))) {
+        declare_variable(frame, counter_name, TYPE_INT, start);
+        counter = hash_table_lookup(frame, counter_name);
+    }
+    store_variable(counter, start);
+    // the counter advances towards the end, until it is equal to it
+    while (counter->value != end) {
+        if (!evaluation_step(evaluation))
+            return EVALUATION_FAILED;
+        if ((result = evaluate_block_at_compile_time(evaluation, node->data.loop.body, frame)) !=
+            EVALUATION_COMPLETED)
+            return result;
+        store_variable(counter, counter->value + (start < end ? 1 : -1));
+    }
+    return EVALUATION_COMPLETED;
+}
+
+EvaluationResult evaluate_statement_at_compile_time(Evaluation *evaluation, AstNode *node, HashTable *frame) {
+    double value;
+    EvaluationVariable *var_a, *var_b;
+    Expression *condition;
+    EvaluationResult result;
+
+    switch (node->type) {
+        case AST_VARIABLE_DECLARATION:
+            if (!evaluate_expression_at_compile_time(
+                    evaluation, &node->data.variable_declaration.value->data.expression, frame, &value))
+                return EVALUATION_FAILED;
+            declare_variable(frame, node->data.variable_declaration.var->name,
+                             node->data.variable_declaration.var->value->type, value);
+            return EVALUATION_COMPLETED;
+        case AST_ASSIGNMENT:
+            var_a = lookup_variable(evaluation, frame, node->data.assignment.dst_variable->value);
+            if (!var_a ||
+                !evaluate_expression_at_compile_time(evaluation, &node->data.assignment.expression->data.expression,
+                                                     frame, &value))
+                return EVALUATION_FAILED;
+            store_variable(var_a, value);
+            return EVALUATION_COMPLETED;
+        case AST_SWAP_STATEMENT:
+            var_a = lookup_variable(evaluation, frame, node->data.swap_statement.var_a->value);
+            var_b = lookup_variable(evaluation, frame, node->data.swap_statement.var_b->value);
+            if (!var_a || !var_b || var_a->type == TYPE_STRING || var_b->type == TYPE_STRING)
+                return EVALUATION_FAILED;
+            value = var_a->value;
+            var_a->value = var_b->value;
+            var_b->value = value;
+            return EVALUATION_COMPLETED;
+        case AST_FUNCTION_CALL:
+            return evaluate_call_at_compile_time(evaluation, node, frame);
+        case AST_IF_STATEMENT:
+            if (!evaluate_expression_at_compile_time(evaluation, &node->data.if_statement.condition->data.expression,
+                                                     frame, &value))
+                return EVALUATION_FAILED;
+            return evaluate_block_at_compile_time(evaluation, value != 0 ? node->data.if_statement.body_node
+                                                                         : node->data.if_statement.else_node, frame);
+        case AST_LOOP:
+            return evaluate_loop_at_compile_time(evaluation, node, frame);
+        case AST_WHILE_LOOP:
+            condition = &node->data.while_loop.condition->data.expression;
+            while (1) {
+                if (!evaluation_step(evaluation) ||
+                    !evaluate_expression_at_compile_time(evaluation, condition, frame, &value))
+                    return EVALUATION_FAILED;
+                if (value == 0)
+                    return EVALUATION_COMPLETED;
+                if ((result = evaluate_block_at_compile_time(evaluation, node->data.while_loop.body, frame)) !=
+                    EVALUATION_COMPLETED)
+                    return result;
+            }
+        case AST_RETURN_STATEMENT:
+            if (node->data.return_statement.value_expr->data.expression.value->type == TYPE_VOID) {
+                evaluation->returned_value = 0;
+            } else if (!evaluate_expression_at_compile_time(
+                    evaluation, &node->data.return_statement.value_expr->data.expression, frame,
+                    &evaluation->returned_value)) {
+                return EVALUATION_FAILED;
+            }
+            return EVALUATION_RETURNED;
+        case AST_NOOP:
+            return EVALUATION_COMPLETED;
+        default:
+            return EVALUATION_FAILED;
+    }
+}
+
+EvaluationResult evaluate_block_at_compile_time(Evaluation *evaluation, List *block, HashTable *frame) {
+    int i;
+    EvaluationResult result;
+
+    for (i = 0; i < block->size; i++) {
+        if (!evaluation_step(evaluation))
+            return EVALUATION_FAILED;
+        if ((result = evaluate_statement_at_compile_time(evaluation, block->items[i], frame)) != EVALUATION_COMPLETED)
+            return result;
+    }
+    return EVALUATION_COMPLETED;
+}
+
+EvaluationResult evaluate_call_at_compile_time(Evaluation *evaluation, AstNode *call, HashTable *caller_frame) {
+    int i, success = 1;
+    double value;
+    Variable *arg;
+    AstNode *definition;
+    HashTable *frame;
+    EvaluationResult result = EVALUATION_FAILED;
+
+    if (hash_table_lookup(builtin_function_to_generator_map, call->data.function_call.func_name))
+        return evaluate_builtin_call(evaluation, call, caller_frame);
+    if ((evaluation->impure_functions &&
+         name_set_contains(evaluation->impure_functions, call->data.function_call.func_name)) ||
+        evaluation->depth >= evaluation->max_depth)
+        return EVALUATION_FAILED;
+    definition = symbol_table_lookup(evaluation->optimizer->symbol_table,
+                                     call->data.function_call.func_name)->initializer;
+
+    frame = init_hash_table(EVALUATION_FRAME_CAPACITY, free);
+    for (i = 0; i < call->data.function_call.args->size && success; i++) {
+        arg = definition->data.function_definition.args->items[i];
+        success = evaluate_expression_at_compile_time(
+                evaluation, &((AstNode *) call->data.function_call.args->items[i])->data.expression, caller_frame,
+                &value);
+        if (success)
+            declare_variable(frame, arg->name, arg->value->type, value);
+    }
+    if (success) {
+        evaluation->depth++;
+        result = evaluate_block_at_compile_time(evaluation, definition->data.function_definition.body, frame);
+        evaluation->depth--;
+        if (result == EVALUATION_COMPLETED) {
+            // the function ended without a return statement, so EAX holds whatever was computed last
+            evaluation->returned_value = 0;
+            if (definition->data.function_definition.returnType != TYPE_VOID)
+                result = EVALUATION_FAILED;
+        } else if (result == EVALUATION_RETURNED) {
+            result = EVALUATION_COMPLETED;
+        }
+    }
+    hash_table_dispose(frame);
+    return result;
+}
+
+// evaluates the calls with constant arguments in a block, and removes the calls that were evaluated
+void evaluate_pure_calls_in_block(Evaluation *evaluation, List *block, HashTable *empty_frame) {
+    int i;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_FUNCTION_CALL:
+                // the arguments are evaluated with an empty frame, so only constant arguments can be evaluated
+                evaluation->steps = 0;
+                evaluation->depth = 0;
+                if (evaluate_call_at_compile_time(evaluation, node, empty_frame) == EVALUATION_COMPLETED) {
+                    list_remove(block, i--);
+                    ast_dispose(node);
+                    evaluation->optimizer->evaluated_call_count++;
+                }
+                break;
+            case AST_IF_STATEMENT:
+                evaluate_pure_calls_in_block(evaluation, node->data.if_statement.body_node, empty_frame);
+                evaluate_pure_calls_in_block(evaluation, node->data.if_statement.else_node, empty_frame);
+                break;
+            case AST_LOOP:
+                evaluate_pure_calls_in_block(evaluation, node->data.loop.body, empty_frame);
+                break;
+            case AST_WHILE_LOOP:
+                evaluate_pure_calls_in_block(evaluation, node->data.while_loop.body, empty_frame);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void evaluate_pure_calls(Optimizer *optimizer) {
+    int i;
+    AstNode *node;
+    List *functions = optimizer->root->data.compound.children;
+    HashTable *empty_frame = init_hash_table(1, free);
+    Evaluation evaluation = {
+            .optimizer = optimizer,
+            .impure_functions = find_impure_functions(optimizer),
+            .globals = NULL,
+            .max_steps = EVALUATION_MAX_STEPS,
+            .max_depth = EVALUATION_MAX_DEPTH,
+    };
+
+    for (i = 0; i < functions->size; i++) {
+        node = functions->items[i];
+        if (node->type == AST_FUNCTION_DEFINITION &&
+            symbol_table_lookup(optimizer->symbol_table,
+                                node->data.function_definition.func_name)->value.func_symbol.reachable)
+            evaluate_pure_calls_in_block(&evaluation, node->data.function_definition.body, empty_frame);
+    }
+
+    hash_table_dispose(empty_frame);
+    name_set_dispose(evaluation.impure_functions);
+}
+
+int evaluate_program(Optimizer *optimizer, Evaluation *evaluation) {
+    int i;
+    AstNode *node, *call;
+    HashTable *empty_frame = init_hash_table(1, free);
+    List *children = optimizer->root->data.compound.children;
+    EvaluationResult result;
+
+    *evaluation = (Evaluation) {
+            .optimizer = optimizer,
+            .impure_functions = NULL,
+            .globals = init_hash_table(EVALUATION_FRAME_CAPACITY, free),
+            .max_steps = PROGRAM_EVALUATION_MAX_STEPS,
+            .max_depth = PROGRAM_EVALUATION_MAX_DEPTH,
+            .output = NULL,
+            .output_length = 0,
+            .output_capacity = 0,
+    };
+    // the global variables are in the .bss segment, and their initializers are not run
+    for (i = 0; i < children->size; i++) {
+        node = children->items[i];
+        if (node->type == AST_VARIABLE_DECLARATION)
+            declare_variable(evaluation->globals, node->data.variable_declaration.var->name,
+                             node->data.variable_declaration.var->value->type, 0);
+    }
+
+    // call the starting point, like the entry point of the generated program
+    call = init_ast(AST_FUNCTION_CALL);
+    call->data.function_call.func_name = optimizer->starting_point->data.function_definition.func_name;
+    result = evaluate_call_at_compile_time(evaluation, call, empty_frame);
+    if (result == EVALUATION_COMPLETED)
+        evaluation->exit_code = optimizer->starting_point->data.function_definition.returnType == TYPE_INT
+                                ? (int) evaluation->returned_value : 0;
+
+    ast_dispose(call);
+    hash_table_dispose(empty_frame);
+    hash_table_dispose(evaluation->globals);
+    evaluation->globals = NULL;
+    if (result == EVALUATION_FAILED) {
+        log_verbose(OPTIMIZER, "Partial evaluation: the program can't be run at compile time, compiling it as usual");
+        free(evaluation->output);
+        evaluation->output = NULL;
+        return 0;
+    }
+    log_verbose(OPTIMIZER, "Partial evaluation: the program was run at compile time "
+                           "(%d byte%s of output, exit code %d)",
+                evaluation->output_length, evaluation->output_length == 1 ? "" : "s", evaluation->exit_code);
+    return 1;
+}
@@ -0,0 +1,101 @@
+#ifndef INFINITY_COMPILER_COMPILE_TIME_EVALUATION_H
+#define INFINITY_COMPILER_COMPILE_TIME_EVALUATION_H
+
+#include "optimizer.h"
+#include "../hash_table/hash_table.h"
+
+// maximum number of statements and loop iterations executed when evaluating a single call
+#define EVALUATION_MAX_STEPS 100000
+// maximum depth of nested calls when evaluating a single call
+#define EVALUATION_MAX_DEPTH 64
+// number of buckets in the hash table of the variables of a function
+#define EVALUATION_FRAME_CAPACITY 16
+
+// limits of the evaluation of the whole program (-fpartial-evaluation)
+#define PROGRAM_EVALUATION_MAX_STEPS 10000000
+#define PROGRAM_EVALUATION_MAX_DEPTH 1000
+#define PROGRAM_EVALUATION_MAX_OUTPUT (1 << 20)
+
+typedef enum EvaluationResult {
+    EVALUATION_COMPLETED, // the statements were executed, go on to the next statement
+    EVALUATION_RETURNED, // a return statement was executed
+    EVALUATION_EXITED, // `exit` was called
+    EVALUATION_FAILED, // the statements can't be evaluated at compile time (or the evaluation exceeded its limits)
+} EvaluationResult;
+
+/**
+\EvaluationVariable
+ A variable of the evaluated program, in a frame (a hash table of variables by name).
+*/
+typedef struct EvaluationVariable {
+    DataType type; // bool and char variables keep only the lowest byte of their value
+    double value;
+} EvaluationVariable;
+
+/**
+\Evaluation
+ State of the compile-time interpreter while it evaluates a call, or the whole program.
+*/
+typedef struct Evaluation {
+    Optimizer *optimizer;
+    List *impure_functions; // names of the functions that have side effects. NULL when evaluating the whole program
+    HashTable *globals; // the global variables. NULL when evaluating a single call, since they may change at runtime
+    int max_steps;
+    int max_depth;
+    int steps; // number of statements and loop iterations executed so far
+    int depth; // depth of nested calls
+    double returned_value; // value of the last executed return statement
+
+    // the output of the whole program
+    char *output;
+    int output_length;
+    int output_capacity;
+    int exit_code;
+} Evaluation;
+
+/// Returns the names of the functions that have side effects: they print, write to a global variable, call `exit`,
+/// or call a function that has side effects. Calls to the other (pure) functions can only compute a value.
+/// \param optimizer
+/// \return Allocated set of function names
+List *find_impure_functions(Optimizer *optimizer);
+
+/// Evaluates an expression of integers, with the values of the variables in a frame.
+/// Follows the semantics of the generated code, and fails where they may differ from the evaluation
+/// (like a division of a negative number, or an overflow).
+/// \param evaluation
+/// \param expr
+/// \param frame Variables of the current function (EvaluationVariable *) by name
+/// \param result Where the value of the expression will be stored
+/// \return If the expression could be evaluated
+int evaluate_expression_at_compile_time(Evaluation *evaluation, Expression *expr, HashTable *frame, double *result);
+
+/// Executes a block of statements at compile time
+/// \param evaluation
+/// \param block List of statements
+/// \param frame Variables of the current function (EvaluationVariable *) by name
+/// \return
+EvaluationResult evaluate_block_at_compile_time(Evaluation *evaluation, List *block, HashTable *frame);
+
+/// Executes a call at compile time. The value the function returned is stored in `returned_value`.
+/// Calls to impure functions (and to print, println and exit) are executed only when evaluating the whole program.
+/// \param evaluation
+/// \param call Function call node
+/// \param caller_frame Variables of the caller, for the arguments
+/// \return EVALUATION_COMPLETED when the function returns, EVALUATION_EXITED or EVALUATION_FAILED
+EvaluationResult evaluate_call_at_compile_time(Evaluation *evaluation, AstNode *call, HashTable *caller_frame);
+
+/// Evaluates the calls to pure functions with constant arguments at compile time.
+/// The value a function returns can't be used by its caller, so a call that is proven to complete
+/// has no effect, and is replaced by its (discarded) result - it is removed.
+/// \param optimizer
+void evaluate_pure_calls(Optimizer *optimizer);
+
+/// Runs the whole program at compile time, from its starting point, and collects its output.
+/// The program takes no input, so when it finishes within the PROGRAM_EVALUATION_MAX_* limits, its output and exit
+/// code are known.
+/// \param optimizer
+/// \param evaluation Where the output and the exit code are stored. The output should be freed by the caller
+/// \return If the program finished within the limits
+int evaluate_program(Optimizer *optimizer, Evaluation *evaluation);
+
+#endif //INFINITY_COMPILER_COMPILE_TIME_EVALUATION_H
@@ -0,0 +1,89 @@
+#include "control_flow.h"
+#include "../semantic_analyzer/semantic_analyzer.h"
+#include <string.h>
+
+int is_constant_condition(Expression *expr) {
+    return !expr->contains_variables;
+}
+
+// whether a block ends with a terminator
+int block_terminates(List *block) {
+    return block->size > 0 && is_terminator(list_get_last(block));
+}
+
+int is_terminator(AstNode *node) {
+    Expression *condition;
+
+    switch (node->type) {
+        case AST_RETURN_STATEMENT:
+            return 1;
+        case AST_FUNCTION_CALL:
+            return strcmp(node->data.function_call.func_name, EXIT_FUNC) == 0;
+        case AST_IF_STATEMENT:
+            return block_terminates(node->data.if_statement.body_node) &&
+                   block_terminates(node->data.if_statement.else_node);
+        case AST_WHILE_LOOP:
+            // there is no way to break out of a loop, other than returning
+            condition = &node->data.while_loop.condition->data.expression;
+            return is_constant_condition(condition) && condition->value->value.double_value != 0;
+        default:
+            return 0;
+    }
+}
+
+void simplify_control_flow(Optimizer *optimizer, List *block) {
+    int i;
+    AstNode *node;
+    List *taken_branch;
+    AstNode *branch_node;
+    Expression *condition;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_IF_STATEMENT:
+                condition = &node->data.if_statement.condition->data.expression;
+                if (is_constant_condition(condition)) {
+                    // replace the if statement with the statements of the taken branch, and simplify them next
+                    taken_branch = condition->value->value.double_value != 0
+                                   ? node->data.if_statement.body_node : node->data.if_statement.else_node;
+                    list_remove(block, i);
+                    while (taken_branch->size > 0) {
+                        branch_node = list_pop(taken_branch);
+                        i < block->size ? list_insert(block, i, branch_node) : list_push(block, branch_node);
+                    }
+                    ast_dispose(node);
+                    optimizer->folded_branch_count++;
+                    i--;
+                    continue;
+                }
+                simplify_control_flow(optimizer, node->data.if_statement.body_node);
+                simplify_control_flow(optimizer, node->data.if_statement.else_node);
+                break;
+            case AST_WHILE_LOOP:
+                condition = &node->data.while_loop.condition->data.expression;
+                if (is_constant_condition(condition) && condition->value->value.double_value == 0) {
+                    ast_dispose(list_remove(block, i));
+                    optimizer->folded_branch_count++;
+                    i--;
+                    continue;
+                }
+                simplify_control_flow(optimizer, node->data.while_loop.body);
+                break;
+            case AST_LOOP:
+                simplify_control_flow(optimizer, node->data.loop.body);
+                break;
+            default:
+                break;
+        }
+
+        if (is_terminator(node)) {
+            // the rest of the block is unreachable
+            while (block->size > i + 1) {
+                ast_dispose(list_pop(block));
+                optimizer->unreachable_statement_count++;
+            }
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef INFINITY_COMPILER_CONTROL_FLOW_H
+#define INFINITY_COMPILER_CONTROL_FLOW_H
+
+#include "optimizer.h"
+
+/// Whether an expression was folded to a constant
+/// \param expr
+/// \return Boolean
+int is_constant_condition(Expression *expr);
+
+/// Whether control never continues after a statement: a return statement, a call to `exit`,
+/// an if statement whose branches both end so, or a loop that runs forever (`while (true)`)
+/// \param node
+/// \return Boolean
+int is_terminator(AstNode *node);
+
+/// Simplifies the control flow of a block: the branches of ifs with constant conditions are replaced by the taken
+/// branch, `while (false)` loops are removed, and so are the statements that follow a terminator (see is_terminator).
+/// \param optimizer
+/// \param block List of statements
+void simplify_control_flow(Optimizer *optimizer, List *block);
+
+#endif //INFINITY_COMPILER_CONTROL_FLOW_H
@@ -0,0 +1,462 @@
+#include "interprocedural.h"
+#include "store_elimination.h"
+#include "storage_allocation.h"
+#include "../config/table_initializers.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include "../expression_evaluator/expression_tree.h"
+#include "../logging/logging.h"
+#include "../io/io.h"
+#include <stdlib.h>
+#include <string.h>
+
+void collect_call_sites(List *call_sites, List *block, Symbol *caller, int in_loop) {
+    int i;
+    AstNode *node;
+    CallSite *call_site;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_FUNCTION_CALL:
+                if (hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name))
+                    break;
+                call_site = malloc(sizeof(CallSite));
+                if (!call_site)
+                    throw_memory_allocation_error(OPTIMIZER);
+                call_site->call = node;
+                call_site->caller = caller;
+                call_site->in_loop = in_loop;
+                list_push(call_sites, call_site);
+                break;
+            case AST_IF_STATEMENT:
+                collect_call_sites(call_sites, node->data.if_statement.body_node, caller, in_loop);
+                collect_call_sites(call_sites, node->data.if_statement.else_node, caller, in_loop);
+                break;
+            case AST_LOOP:
+                collect_call_sites(call_sites, node->data.loop.body, caller, 1);
+                break;
+            case AST_WHILE_LOOP:
+                collect_call_sites(call_sites, node->data.while_loop.body, caller, 1);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int is_var_written(List *block, char *var_name) {
+    int i;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                if (strcmp(node->data.variable_declaration.var->name, var_name) == 0)
+                    return 1;
+                break;
+            case AST_ASSIGNMENT:
+                if (strcmp(node->data.assignment.dst_variable->value, var_name) == 0)
+                    return 1;
+                break;
+            case AST_SWAP_STATEMENT:
+                if (strcmp(node->data.swap_statement.var_a->value, var_name) == 0 ||
+                    strcmp(node->data.swap_statement.var_b->value, var_name) == 0)
+                    return 1;
+                break;
+            case AST_IF_STATEMENT:
+                if (is_var_written(node->data.if_statement.body_node, var_name) ||
+                    is_var_written(node->data.if_statement.else_node, var_name))
+                    return 1;
+                break;
+            case AST_LOOP:
+                if ((node->data.loop.loop_counter_name && strcmp(node->data.loop.loop_counter_name, var_name) == 0) ||
+                    is_var_written(node->data.loop.body, var_name))
+                    return 1;
+                break;
+            case AST_WHILE_LOOP:
+                if (is_var_written(node->data.while_loop.body, var_name))
+                    return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+int is_constant_number(Expression *expr) {
+    return !expr->contains_variables && expr->value->type != TYPE_STRING && expr->value->type != TYPE_VOID;
+}
+
+// whether the expression results in a boolean (print shows such expressions as true/false)
+int is_boolean_expression(Expression *expr) {
+    ArithmeticToken *token = list_get_last(expr->tokens);
+    return token->type == OPERATOR &&
+           (is_relational_operator(token->value.op) || strcmp(token->value.op, OP_LOGICAL_AND) == 0 ||
+            strcmp(token->value.op, OP_LOGICAL_OR) == 0 || strcmp(token->value.op, OP_NOT) == 0);
+}
+
+void substitute_constant(Optimizer *optimizer, Expression *expr, char *var_name, double value, int can_fold) {
+    int i, replaced = 0, remaining_vars = 0, exact = 1;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables || expr->value->type == TYPE_STRING)
+        return;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == VAR && strcmp(token->value.var, var_name) == 0) {
+            token->type = NUMBER;
+            token->value.number = value;
+            replaced = 1;
+        } else if (token->type == VAR) {
+            remaining_vars = 1;
+        } else if (token->type == OPERATOR &&
+                   (strcmp(token->value.op, OP_DIV) == 0 || strcmp(token->value.op, OP_MOD) == 0 ||
+                    strcmp(token->value.op, OP_POW) == 0 || strcmp(token->value.op, OP_FACT) == 0)) {
+            // the evaluator computes these in floating point, unlike the generated code
+            exact = 0;
+        }
+    }
+    if (replaced && !remaining_vars && exact && can_fold) {
+        expr->value->value.double_value = evaluate_postfix(expr->tokens, optimizer->lexer);
+        expr->contains_variables = 0;
+    }
+}
+
+void substitute_constant_in_block(Optimizer *optimizer, List *block, char *var_name, double value) {
+    int i, j, is_builtin;
+    AstNode *node;
+    Expression *arg_expr;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                substitute_constant(optimizer, &node->data.variable_declaration.value->data.expression, var_name,
+                                    value, 1);
+                break;
+            case AST_ASSIGNMENT:
+                substitute_constant(optimizer, &node->data.assignment.expression->data.expression, var_name, value, 1);
+                break;
+            case AST_FUNCTION_CALL:
+                is_builtin = hash_table_lookup(builtin_function_to_generator_map,
+                                               node->data.function_call.func_name) != NULL;
+                for (j = 0; j < node->data.function_call.args->size; j++) {
+                    arg_expr = &((AstNode *) node->data.function_call.args->items[j])->data.expression;
+                    // folded booleans would be printed as numbers
+                    substitute_constant(optimizer, arg_expr, var_name, value,
+                                        !is_builtin || !arg_expr->contains_variables ||
+                                        !is_boolean_expression(arg_expr));
+                }
+                break;
+            case AST_RETURN_STATEMENT:
+                substitute_constant(optimizer, &node->data.return_statement.value_expr->data.expression, var_name,
+                                    value, 1);
+                break;
+            case AST_IF_STATEMENT:
+                substitute_constant(optimizer, &node->data.if_statement.condition->data.expression, var_name, value,
+                                    1);
+                substitute_constant_in_block(optimizer, node->data.if_statement.body_node, var_name, value);
+                substitute_constant_in_block(optimizer, node->data.if_statement.else_node, var_name, value);
+                break;
+            case AST_LOOP:
+                // the generated range checks of a constant range assume it was validated by the analyzer
+                if (node->data.loop.loop_counter_name)
+                    substitute_constant(optimizer, node->data.loop.start, var_name, value, 0);
+                substitute_constant(optimizer, node->data.loop.end, var_name, value, 0);
+                substitute_constant_in_block(optimizer, node->data.loop.body, var_name, value);
+                break;
+            case AST_WHILE_LOOP:
+                substitute_constant(optimizer, &node->data.while_loop.condition->data.expression, var_name, value,
+                                    1);
+                substitute_constant_in_block(optimizer, node->data.while_loop.body, var_name, value);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void copy_expression(Expression *dst, Expression *src) {
+    int i;
+    ArithmeticToken *token;
+
+    *dst = *src;
+    dst->value = init_literal_value(src->value->type, src->value->value);
+    dst->tokens = init_list(sizeof(ArithmeticToken *));
+    for (i = 0; i < src->tokens->size; i++) {
+        // only the arithmetic tokens of expressions with variables are changed by the optimizer
+        if (src->contains_variables && src->value->type != TYPE_STRING) {
+            token = init_empty_arithmetic_token();
+            *token = *(ArithmeticToken *) src->tokens->items[i];
+            list_push(dst->tokens, token);
+        } else {
+            list_push(dst->tokens, src->tokens->items[i]);
+        }
+    }
+}
+
+AstNode *copy_expression_node(AstNode *node) {
+    AstNode *copy = init_ast(AST_EXPRESSION);
+    free(copy->data.expression.tokens->items);
+    free(copy->data.expression.tokens);
+    copy_expression(&copy->data.expression, &node->data.expression);
+    return copy;
+}
+
+AstNode *copy_statement(AstNode *node) {
+    int i;
+    AstNode *copy = malloc(sizeof(AstNode));
+    if (!copy)
+        throw_memory_allocation_error(OPTIMIZER);
+    *copy = *node;
+
+    switch (node->type) {
+        case AST_VARIABLE_DECLARATION:
+            copy->data.variable_declaration.value = copy_expression_node(node->data.variable_declaration.value);
+            break;
+        case AST_ASSIGNMENT:
+            copy->data.assignment.expression = copy_expression_node(node->data.assignment.expression);
+            break;
+        case AST_FUNCTION_DEFINITION:
+            copy->data.function_definition.body = copy_block(node->data.function_definition.body);
+            break;
+        case AST_FUNCTION_CALL:
+            copy->data.function_call.args = init_list(sizeof(AstNode *));
+            for (i = 0; i < node->data.function_call.args->size; i++)
+                list_push(copy->data.function_call.args,
+                          copy_expression_node(node->data.function_call.args->items[i]));
+            copy->data.function_call.is_tail_call = 0;
+            break;
+        case AST_IF_STATEMENT:
+            copy->data.if_statement.condition = copy_expression_node(node->data.if_statement.condition);
+            copy->data.if_statement.body_node = copy_block(node->data.if_statement.body_node);
+            copy->data.if_statement.else_node = copy_block(node->data.if_statement.else_node);
+            break;
+        case AST_LOOP:
+            copy->data.loop.start = malloc(sizeof(Expression));
+            copy->data.loop.end = malloc(sizeof(Expression));
+            if (!copy->data.loop.start || !copy->data.loop.end)
+                throw_memory_allocation_error(OPTIMIZER);
+            copy_expression(copy->data.loop.start, node->data.loop.start);
+            copy_expression(copy->data.loop.end, node->data.loop.end);
+            copy->data.loop.body = copy_block(node->data.loop.body);
+            break;
+        case AST_WHILE_LOOP:
+            copy->data.while_loop.condition = copy_expression_node(node->data.while_loop.condition);
+            copy->data.while_loop.body = copy_block(node->data.while_loop.body);
+            break;
+        case AST_RETURN_STATEMENT:
+            copy->data.return_statement.value_expr = copy_expression_node(node->data.return_statement.value_expr);
+            break;
+        default:
+            break;
+    }
+    return copy;
+}
+
+List *copy_block(List *block) {
+    int i;
+    List *copy = init_list(sizeof(AstNode *));
+    for (i = 0; i < block->size; i++)
+        list_push(copy, copy_statement(block->items[i]));
+    return copy;
+}
+
+int count_statements(List *block) {
+    int i, count = block->size;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+        if (node->type == AST_IF_STATEMENT)
+            count += count_statements(node->data.if_statement.body_node) +
+                     count_statements(node->data.if_statement.else_node);
+        else if (node->type == AST_LOOP)
+            count += count_statements(node->data.loop.body);
+        else if (node->type == AST_WHILE_LOOP)
+            count += count_statements(node->data.while_loop.body);
+    }
+    return count;
+}
+
+// finds the constant an argument gets at every call site of a function.
+// calls of the function to itself may also pass the argument on unchanged.
+int get_constant_argument(List *call_sites, AstNode *function, int arg_index, double *value) {
+    int i, found = 0;
+    CallSite *call_site;
+    Expression *arg_expr;
+    ArithmeticToken *token;
+    char *arg_name = ((Variable *) function->data.function_definition.args->items[arg_index])->name;
+
+    for (i = 0; i < call_sites->size; i++) {
+        call_site = call_sites->items[i];
+        if (strcmp(call_site->call->data.function_call.func_name, function->data.function_definition.func_name) != 0)
+            continue;
+        arg_expr = &((AstNode *) call_site->call->data.function_call.args->items[arg_index])->data.expression;
+
+        if (is_constant_number(arg_expr)) {
+            if (found && arg_expr->value->value.double_value != *value)
+                return 0;
+            *value = arg_expr->value->value.double_value;
+            found = 1;
+        } else if (call_site->caller->initializer == function && arg_expr->contains_variables &&
+                   arg_expr->tokens->size == 1 && (token = arg_expr->tokens->items[0])->type == VAR &&
+                   strcmp(token->value.var, arg_name) == 0) {
+            // passed on unchanged
+        } else {
+            return 0;
+        }
+    }
+    return found;
+}
+
+Symbol *create_specialization(Optimizer *optimizer, Symbol *function, AstNode *call) {
+    int i;
+    char *name;
+    Variable *arg;
+    Expression *arg_expr;
+    AstNode *copy = copy_statement(function->initializer);
+    List *callees = init_list(sizeof(Symbol *));
+
+    alsprintf(&name, SPECIALIZATION_NAME_FORMAT, function->value.func_symbol.func_name,
+              ++optimizer->specialized_function_count);
+    copy->data.function_definition.func_name = name;
+    for (i = 0; i < copy->data.function_definition.args->size; i++) {
+        arg = copy->data.function_definition.args->items[i];
+        arg_expr = &((AstNode *) call->data.function_call.args->items[i])->data.expression;
+        if (is_constant_number(arg_expr) && !is_var_written(copy->data.function_definition.body, arg->name))
+            substitute_constant_in_block(optimizer, copy->data.function_definition.body, arg->name,
+                                         arg_expr->value->value.double_value);
+    }
+    for (i = 0; i < function->value.func_symbol.callees->size; i++)
+        list_push(callees, function->value.func_symbol.callees->items[i]);
+
+    list_push(optimizer->root->data.compound.children, copy);
+    symbol_table_insert(optimizer->symbol_table, FUNCTION, name, (SymbolValue) {.func_symbol = (FunctionSymbol) {
+            .func_name = name,
+            .arg_types = copy->data.function_definition.args,
+            .returned = function->value.func_symbol.returned,
+            .callees = callees,
+            .reachable = 1,
+            .vars = NULL,
+            .shared_slots = NULL,
+            .fastcall = function->value.func_symbol.fastcall
+    }}, copy);
+    return symbol_table_lookup(optimizer->symbol_table, name);
+}
+
+void specialize_hot_call_sites(Optimizer *optimizer, List *call_sites) {
+    int i, j, size, constant_count, budget = SPECIALIZATION_BUDGET;
+    char *key, *new_key;
+    CallSite *call_site;
+    Symbol *function, *specialization;
+    AstNode *definition;
+    Variable *arg;
+    Expression *arg_expr;
+    List *referenced;
+    HashTable *specializations = init_hash_table(16, NULL); // signature -> specialized function symbol
+
+    for (i = 0; i < call_sites->size; i++) {
+        call_site = call_sites->items[i];
+        function = symbol_table_lookup(optimizer->symbol_table, call_site->call->data.function_call.func_name);
+        definition = function->initializer;
+        if (!call_site->in_loop || list_contains(function->value.func_symbol.callees, function))
+            continue;
+        size = count_statements(definition->data.function_definition.body);
+        if (size > SPECIALIZATION_MAX_STATEMENTS)
+            continue;
+
+        // the signature of the specialization: the constant arguments that the function uses
+        referenced = init_list(sizeof(char *));
+        collect_referenced_vars(referenced, definition->data.function_definition.body);
+        key = strdup(function->value.func_symbol.func_name);
+        constant_count = 0;
+        for (j = 0; j < definition->data.function_definition.args->size; j++) {
+            arg = definition->data.function_definition.args->items[j];
+            arg_expr = &((AstNode *) call_site->call->data.function_call.args->items[j])->data.expression;
+            if (is_constant_number(arg_expr) && name_set_contains(referenced, arg->name) &&
+                !is_var_written(definition->data.function_definition.body, arg->name)) {
+                alsprintf(&new_key, "%s,%.17g", key, arg_expr->value->value.double_value);
+                constant_count++;
+            } else {
+                alsprintf(&new_key, "%s,_", key);
+            }
+            free(key);
+            key = new_key;
+        }
+        name_set_dispose(referenced);
+
+        if (constant_count == 0 ||
+            (!(specialization = hash_table_lookup(specializations, key)) && size > budget)) {
+            free(key);
+            continue;
+        }
+        if (!specialization) {
+            budget -= size;
+            specialization = create_specialization(optimizer, function, call_site->call);
+            hash_table_insert(specializations, key, specialization);
+        } else {
+            free(key);
+        }
+        call_site->call->data.function_call.func_name = specialization->value.func_symbol.func_name;
+        if (!list_contains(call_site->caller->value.func_symbol.callees, specialization))
+            list_push(call_site->caller->value.func_symbol.callees, specialization);
+        optimizer->specialized_call_count++;
+    }
+    hash_table_dispose(specializations);
+}
+
+void propagate_constant_arguments(Optimizer *optimizer) {
+    int i, j, changed;
+    double value;
+    AstNode *node;
+    Symbol *symbol;
+    Variable *arg;
+    List *referenced;
+    List *call_sites = init_list(sizeof(CallSite *));
+    List *functions = optimizer->root->data.compound.children;
+
+    for (i = 0; i < functions->size; i++) {
+        node = functions->items[i];
+        if (node->type != AST_FUNCTION_DEFINITION)
+            continue;
+        symbol = symbol_table_lookup(optimizer->symbol_table, node->data.function_definition.func_name);
+        if (symbol->value.func_symbol.reachable)
+            collect_call_sites(call_sites, node->data.function_definition.body, symbol, 0);
+    }
+
+    // replacing an argument can make the arguments the function passes on constant, so repeat until nothing changes
+    do {
+        changed = 0;
+        for (i = 0; i < functions->size; i++) {
+            node = functions->items[i];
+            if (node->type != AST_FUNCTION_DEFINITION || node == optimizer->starting_point ||
+                !symbol_table_lookup(optimizer->symbol_table,
+                                     node->data.function_definition.func_name)->value.func_symbol.reachable)
+                continue;
+
+            referenced = init_list(sizeof(char *));
+            collect_referenced_vars(referenced, node->data.function_definition.body);
+            for (j = 0; j < node->data.function_definition.args->size; j++) {
+                arg = node->data.function_definition.args->items[j];
+                if (name_set_contains(referenced, arg->name) &&
+                    !is_var_written(node->data.function_definition.body, arg->name) &&
+                    get_constant_argument(call_sites, node, j, &value)) {
+                    substitute_constant_in_block(optimizer, node->data.function_definition.body, arg->name, value);
+                    optimizer->constant_argument_count++;
+                    changed = 1;
+                }
+            }
+            name_set_dispose(referenced);
+        }
+    } while (changed);
+
+    specialize_hot_call_sites(optimizer, call_sites);
+
+    list_dispose(call_sites);
+}
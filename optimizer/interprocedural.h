@@ -0,0 +1,67 @@
+#ifndef INFINITY_COMPILER_INTERPROCEDURAL_H
+#define INFINITY_COMPILER_INTERPROCEDURAL_H
+
+#include "optimizer.h"
+
+// name of a specialized copy of a function: <function name>.<copy number>
+#define SPECIALIZATION_NAME_FORMAT "%s.%d"
+// functions with more statements than this are not specialized
+#define SPECIALIZATION_MAX_STATEMENTS 30
+// total number of statements that specialization may add to the program
+#define SPECIALIZATION_BUDGET 120
+
+/**
+\CallSite
+ A call to a user function, found in a reachable function.
+*/
+typedef struct CallSite {
+    AstNode *call; // function call node
+    Symbol *caller; // symbol of the calling function
+    int in_loop; // if the call is inside a loop (a hot call site)
+} CallSite;
+
+/// Adds the calls to user functions in a block to a list of call sites
+/// \param call_sites List of CallSite
+/// \param block List of statements
+/// \param caller Symbol of the function the block belongs to
+/// \param in_loop If the block is inside a loop
+void collect_call_sites(List *call_sites, List *block, Symbol *caller, int in_loop);
+
+/// Whether a block (or a nested block in it) changes the value of a variable
+/// \param block List of statements
+/// \param var_name
+/// \return Boolean
+int is_var_written(List *block, char *var_name);
+
+/// Whether an expression is a constant number
+/// \param expr
+/// \return Boolean
+int is_constant_number(Expression *expr);
+
+/// Replaces the uses of a variable in the expressions of a block with a constant.
+/// Expressions left without variables are folded, unless folding could change their behavior.
+/// \param optimizer
+/// \param block List of statements
+/// \param var_name
+/// \param value The constant value of the variable
+void substitute_constant_in_block(Optimizer *optimizer, List *block, char *var_name, double value);
+
+/// Returns a deep copy of a block, for specialized copies of functions.
+/// Variables, names and source tokens are shared with the original block.
+/// \param block List of statements
+/// \return Allocated list of statements
+List *copy_block(List *block);
+
+/// Returns the number of statements in a block, including the statements of nested blocks
+/// \param block List of statements
+/// \return
+int count_statements(List *block);
+
+/// Interprocedural constant propagation over the call graph:
+/// arguments that get the same constant at every call site are replaced by the constant in the function body,
+/// and calls inside loops that pass constants call a copy of the function specialized for these constants
+/// (for small, non-recursive functions, as long as the total size of the copies is within SPECIALIZATION_BUDGET).
+/// \param optimizer
+void propagate_constant_arguments(Optimizer *optimizer);
+
+#endif //INFINITY_COMPILER_INTERPROCEDURAL_H
@@ -0,0 +1,110 @@
+#include "optimizer.h"
+#include "store_elimination.h"
+#include "storage_allocation.h"
+#include "tail_calls.h"
+#include "control_flow.h"
+#include "interprocedural.h"
+#include "compile_time_evaluation.h"
+#include "scalar_evolution.h"
+#include "strength_reduction.h"
+#include "print_folding.h"
+#include "../logging/logging.h"
+#include <stdlib.h>
+
+Optimizer *init_optimizer(AstNode *root, AstNode *starting_point, SymbolTable *symbol_table, Lexer *lexer) {
+    int i;
+    AstNode *node;
+    Optimizer *optimizer = malloc(sizeof(Optimizer));
+    if (!optimizer)
+        throw_memory_allocation_error(OPTIMIZER);
+
+    optimizer->root = root;
+    optimizer->starting_point = starting_point;
+    optimizer->symbol_table = symbol_table;
+    optimizer->lexer = lexer;
+    optimizer->dead_store_count = 0;
+    optimizer->propagated_copy_count = 0;
+    optimizer->tail_call_count = 0;
+    optimizer->folded_branch_count = 0;
+    optimizer->unreachable_statement_count = 0;
+    optimizer->constant_argument_count = 0;
+    optimizer->specialized_function_count = 0;
+    optimizer->specialized_call_count = 0;
+    optimizer->evaluated_call_count = 0;
+    optimizer->closed_form_loop_count = 0;
+    optimizer->induction_variable_count = 0;
+    optimizer->eliminated_counter_count = 0;
+    optimizer->folded_print_argument_count = 0;
+    optimizer->folded_string_count = 0;
+
+    optimizer->global_vars = init_list(sizeof(char *));
+    for (i = 0; i < root->data.compound.children->size; i++) {
+        node = root->data.compound.children->items[i];
+        if (node->type == AST_VARIABLE_DECLARATION)
+            list_push(optimizer->global_vars, node->data.variable_declaration.var->name);
+    }
+
+    return optimizer;
+}
+
+void optimizer_dispose(Optimizer *optimizer) {
+    name_set_dispose(optimizer->global_vars);
+    free(optimizer);
+}
+
+int optimizer_is_global_var(Optimizer *optimizer, char *var_name) {
+    return name_set_contains(optimizer->global_vars, var_name);
+}
+
+void optimizer_optimize(Optimizer *optimizer) {
+    int i;
+    AstNode *node;
+    List *functions = optimizer->root->data.compound.children;
+
+    propagate_constant_arguments(optimizer);
+    evaluate_pure_calls(optimizer);
+    for (i = 0; i < functions->size; i++) {
+        node = functions->items[i];
+        if (node->type != AST_FUNCTION_DEFINITION ||
+            !symbol_table_lookup(optimizer->symbol_table,
+                                 node->data.function_definition.func_name)->value.func_symbol.reachable)
+            continue;
+
+        simplify_control_flow(optimizer, node->data.function_definition.body);
+        replace_loops_with_closed_forms(optimizer, node->data.function_definition.body, node);
+        propagate_copies(optimizer, node->data.function_definition.body);
+        reduce_induction_variables(optimizer, node->data.function_definition.body, node);
+        eliminate_dead_stores(optimizer, node);
+        fold_prints(optimizer, node->data.function_definition.body);
+        // the value returned from a call can't be used, so only functions that return nothing have tail calls
+        if (node->data.function_definition.returnType == TYPE_VOID)
+            mark_tail_calls(optimizer, node->data.function_definition.body, 1);
+    }
+
+    log_verbose(OPTIMIZER, "Interprocedural constant propagation: %d argument%s replaced by constants, "
+                           "%d specialized function%s for %d call%s in loops",
+                optimizer->constant_argument_count, optimizer->constant_argument_count == 1 ? "" : "s",
+                optimizer->specialized_function_count, optimizer->specialized_function_count == 1 ? "" : "s",
+                optimizer->specialized_call_count, optimizer->specialized_call_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Compile-time evaluation: %d call%s to pure functions evaluated and removed",
+                optimizer->evaluated_call_count, optimizer->evaluated_call_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Control flow simplification: %d constant branch%s folded, %d unreachable statement%s removed",
+                optimizer->folded_branch_count, optimizer->folded_branch_count == 1 ? "" : "es",
+                optimizer->unreachable_statement_count, optimizer->unreachable_statement_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Scalar evolution: %d loop%s replaced by closed forms", optimizer->closed_form_loop_count,
+                optimizer->closed_form_loop_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Copy propagation: %d use%s replaced", optimizer->propagated_copy_count,
+                optimizer->propagated_copy_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Strength reduction: %d induction variable%s derived, %d loop counter%s eliminated",
+                optimizer->induction_variable_count, optimizer->induction_variable_count == 1 ? "" : "s",
+                optimizer->eliminated_counter_count, optimizer->eliminated_counter_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Dead store elimination: %d store%s removed", optimizer->dead_store_count,
+                optimizer->dead_store_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Print folding: %d constant argument%s folded into %d string%s",
+                optimizer->folded_print_argument_count, optimizer->folded_print_argument_count == 1 ? "" : "s",
+                optimizer->folded_string_count, optimizer->folded_string_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Tail calls: %d call%s in tail position", optimizer->tail_call_count,
+                optimizer->tail_call_count == 1 ? "" : "s");
+
+    allocate_variable_storage(optimizer);
+}
@@ -0,0 +1,52 @@
+#ifndef INFINITY_COMPILER_OPTIMIZER_H
+#define INFINITY_COMPILER_OPTIMIZER_H
+
+#include "../ast/ast.h"
+#include "../symbol_table/symbol_table.h"
+#include "../lexer/lexer.h"
+
+/**
+\Optimizer
+ Transforms the analyzed AST before the code generation.
+*/
+typedef struct Optimizer {
+    AstNode *root; // root node of the AST tree
+    AstNode *starting_point; // starting point of the application
+    SymbolTable *symbol_table;
+
+    List *global_vars; // names of the variables declared outside of functions
+
+    // statistics, for the verbose output
+    int dead_store_count;
+    int propagated_copy_count;
+    int tail_call_count;
+    int folded_branch_count;
+    int unreachable_statement_count;
+    int constant_argument_count;
+    int specialized_function_count;
+    int specialized_call_count;
+    int evaluated_call_count;
+    int closed_form_loop_count;
+    int induction_variable_count;
+    int eliminated_counter_count;
+    int folded_print_argument_count;
+    int folded_string_count;
+
+    Lexer *lexer; // for error reporting
+} Optimizer;
+
+Optimizer *init_optimizer(AstNode *root, AstNode *starting_point, SymbolTable *symbol_table, Lexer *lexer);
+
+void optimizer_dispose(Optimizer *optimizer);
+
+/// Runs the optimization passes on every function of the program.
+/// \param optimizer
+void optimizer_optimize(Optimizer *optimizer);
+
+/// Whether a variable is declared outside of functions (and can be accessed by any function)
+/// \param optimizer
+/// \param var_name
+/// \return Boolean
+int optimizer_is_global_var(Optimizer *optimizer, char *var_name);
+
+#endif //INFINITY_COMPILER_OPTIMIZER_H
@@ -0,0 +1,140 @@
+#include "print_folding.h"
+#include "../semantic_analyzer/semantic_analyzer.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include "../logging/logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// formats a constant argument of print, the way generate_print prints it. returns its length
+int format_constant_argument(Optimizer *optimizer, Expression *expr, char *buf) {
+    StringSymbol *str_sym;
+    ArithmeticToken *token;
+
+    if (expr->value->type == TYPE_STRING) {
+        str_sym = string_repository_lookup(optimizer->symbol_table->str_repo, expr->value->value.string_value);
+        if (str_sym->length > MAX_FOLDED_STRING_LENGTH)
+            return -1;
+        memcpy(buf, str_sym->value, str_sym->length);
+        return (int) str_sym->length;
+    }
+    token = expr->tokens->size == 1 ? expr->tokens->items[0] : NULL;
+    if (token && token->original_tok->type == CHAR) {
+        buf[0] = token->original_tok->value[0];
+        return 1;
+    }
+    return sprintf(buf, "%d", (int) expr->value->value.double_value);
+}
+
+AstNode *init_string_argument(Optimizer *optimizer, char *text, int length) {
+    AstNode *node = init_ast(AST_EXPRESSION);
+    char *value = malloc(length + 1);
+    StringSymbol *str_sym;
+
+    if (!value)
+        throw_memory_allocation_error(OPTIMIZER);
+    memcpy(value, text, length);
+    value[length] = 0;
+    // identical strings share a symbol
+    if ((str_sym = string_repository_lookup(optimizer->symbol_table->str_repo, value))) {
+        free(value);
+        value = str_sym->value;
+    } else {
+        string_repository_add_string_identifier(optimizer->symbol_table->str_repo, value);
+        optimizer->folded_string_count++;
+    }
+    node->data.expression.value = init_literal_value(TYPE_STRING, (Value) {.string_value = value});
+    node->data.expression.contains_variables = 0;
+    return node;
+}
+
+// replaces a run of constant arguments with a single string, when it's worth it
+void flush_constant_run(Optimizer *optimizer, List *run, List *new_args, char *text, int length, int with_new_line) {
+    int i;
+    AstNode *arg;
+
+    if (run->size == 0)
+        return;
+    arg = run->items[0];
+    // a single string is printed as it is
+    if (run->size == 1 && !with_new_line && arg->data.expression.value->type == TYPE_STRING) {
+        list_push(new_args, arg);
+        return;
+    }
+    list_push(new_args, init_string_argument(optimizer, text, length));
+    for (i = 0; i < run->size; i++)
+        ast_dispose(run->items[i]);
+    optimizer->folded_print_argument_count += run->size + with_new_line;
+}
+
+void fold_print_call(Optimizer *optimizer, AstNode *node) {
+    int i, length = 0, arg_length;
+    char text[MAX_FOLDED_STRING_LENGTH + 1], arg_text[MAX_FOLDED_STRING_LENGTH + 1];
+    List *args = node->data.function_call.args, *new_args = init_list(sizeof(AstNode *));
+    List *run = init_list(sizeof(AstNode *)); // the current run of constant arguments
+    AstNode *arg;
+    Expression *expr;
+
+    for (i = 0; i < args->size; i++) {
+        arg = args->items[i];
+        expr = &arg->data.expression;
+        arg_length = expr->contains_variables ? -1 : format_constant_argument(optimizer, expr, arg_text);
+        if (arg_length < 0 || length + arg_length > MAX_FOLDED_STRING_LENGTH) {
+            flush_constant_run(optimizer, run, new_args, text, length, 0);
+            list_clear(run, 0);
+            length = 0;
+        }
+        if (arg_length < 0) {
+            list_push(new_args, arg);
+            continue;
+        }
+        memcpy(text + length, arg_text, arg_length);
+        length += arg_length;
+        list_push(run, arg);
+    }
+
+    // the new line of println joins a run at the end
+    if (strcmp(node->data.function_call.func_name, PRINTLN_FUNC) == 0 && run->size > 0 &&
+        length < MAX_FOLDED_STRING_LENGTH) {
+        text[length++] = '\r';
+        node->data.function_call.func_name = PRINT_FUNC;
+        flush_constant_run(optimizer, run, new_args, text, length, 1);
+    } else {
+        flush_constant_run(optimizer, run, new_args, text, length, 0);
+    }
+
+    free(run->items);
+    free(run);
+    free(args->items);
+    free(args);
+    node->data.function_call.args = new_args;
+}
+
+void fold_prints(Optimizer *optimizer, List *block) {
+    int i;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_FUNCTION_CALL:
+                if (strcmp(node->data.function_call.func_name, PRINT_FUNC) == 0 ||
+                    strcmp(node->data.function_call.func_name, PRINTLN_FUNC) == 0)
+                    fold_print_call(optimizer, node);
+                break;
+            case AST_IF_STATEMENT:
+                fold_prints(optimizer, node->data.if_statement.body_node);
+                fold_prints(optimizer, node->data.if_statement.else_node);
+                break;
+            case AST_LOOP:
+                fold_prints(optimizer, node->data.loop.body);
+                break;
+            case AST_WHILE_LOOP:
+                fold_prints(optimizer, node->data.while_loop.body);
+                break;
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef INFINITY_COMPILER_PRINT_FOLDING_H
+#define INFINITY_COMPILER_PRINT_FOLDING_H
+
+#include "optimizer.h"
+
+// the length of a string literal is stored in a byte before it, so a folded string is not longer than that
+#define MAX_FOLDED_STRING_LENGTH 255
+
+/// Formats the constant arguments of print and println at compile time, and merges runs of adjacent constant
+/// arguments (with the new line of println, when its last argument is constant) into a single string literal,
+/// so they are printed with a single `write` system call.
+/// \param optimizer
+/// \param block List of statements
+void fold_prints(Optimizer *optimizer, List *block);
+
+#endif //INFINITY_COMPILER_PRINT_FOLDING_H
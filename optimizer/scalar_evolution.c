@@ -0,0 +1,438 @@
+#include "scalar_evolution.h"
+#include "store_elimination.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include "../logging/logging.h"
+#include "../io/io.h"
+#include <stdlib.h>
+#include <string.h>
+
+int is_invariant_subtree(ExpressionNode *node, List *written_vars) {
+    if (!node)
+        return 1;
+    if (node->token->type == VAR)
+        return !name_set_contains(written_vars, node->token->value.var);
+    // these may stop the program (or take long) when the loop doesn't run at all
+    if (expression_node_is_operator(node, OP_DIV) || expression_node_is_operator(node, OP_MOD) ||
+        expression_node_is_operator(node, OP_POW) || expression_node_is_operator(node, OP_FACT))
+        return 0;
+    return is_invariant_subtree(node->left, written_vars) && is_invariant_subtree(node->right, written_vars);
+}
+
+int is_var_node(ExpressionNode *node, char *var_name) {
+    return var_name && node->token->type == VAR && strcmp(node->token->value.var, var_name) == 0;
+}
+
+void add_recurrence_term(List *terms, int degree, int sign, ExpressionNode *coefficient) {
+    RecurrenceTerm *term = malloc(sizeof(RecurrenceTerm));
+    if (!term)
+        throw_memory_allocation_error(OPTIMIZER);
+    term->degree = degree;
+    term->sign = sign;
+    term->coefficient = coefficient;
+    list_push(terms, term);
+}
+
+// adds a term of the form: coefficient * counter^degree
+int add_monomial(ExpressionNode *node, int sign, char *counter_name, List *written_vars, List *terms) {
+    if (is_invariant_subtree(node, written_vars)) {
+        add_recurrence_term(terms, 0, sign, node);
+    } else if (is_var_node(node, counter_name)) {
+        add_recurrence_term(terms, 1, sign, NULL);
+    } else if (expression_node_is_operator(node, OP_MUL)) {
+        if (is_var_node(node->left, counter_name) && is_var_node(node->right, counter_name))
+            add_recurrence_term(terms, 2, sign, NULL);
+        else if (is_var_node(node->left, counter_name) && is_invariant_subtree(node->right, written_vars))
+            add_recurrence_term(terms, 1, sign, node->right);
+        else if (is_var_node(node->right, counter_name) && is_invariant_subtree(node->left, written_vars))
+            add_recurrence_term(terms, 1, sign, node->left);
+        else
+            return 0;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// splits a sum into terms. counts the occurrences of the assigned variable in `var_count`
+int collect_recurrence_terms(ExpressionNode *node, int sign, char *var_name, char *counter_name, List *written_vars,
+                             List *terms, int *var_count) {
+    if (is_var_node(node, var_name)) {
+        (*var_count)++;
+        return sign == 1;
+    }
+    if (expression_node_is_operator(node, OP_ADD))
+        return collect_recurrence_terms(node->left, sign, var_name, counter_name, written_vars, terms, var_count) &&
+               collect_recurrence_terms(node->right, sign, var_name, counter_name, written_vars, terms, var_count);
+    if (expression_node_is_operator(node, OP_SUB))
+        return collect_recurrence_terms(node->left, sign, var_name, counter_name, written_vars, terms, var_count) &&
+               collect_recurrence_terms(node->right, -sign, var_name, counter_name, written_vars, terms, var_count);
+    return add_monomial(node, sign, counter_name, written_vars, terms);
+}
+
+int get_recurrence_terms(ExpressionNode *root, char *var_name, char *counter_name, List *written_vars, List *terms) {
+    int var_count = 0;
+    return collect_recurrence_terms(root, 1, var_name, counter_name, written_vars, terms, &var_count) &&
+           var_count == 1;
+}
+
+int get_polynomial_terms(ExpressionNode *root, char *counter_name, List *written_vars, List *terms) {
+    int var_count = 0;
+    return collect_recurrence_terms(root, 1, NULL, counter_name, written_vars, terms, &var_count);
+}
+
+// whether an expression reads one of the variables in a set
+int expression_reads_any(Expression *expr, List *var_names) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables || expr->value->type == TYPE_STRING)
+        return 0;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == VAR && name_set_contains(var_names, token->value.var))
+            return 1;
+    }
+    return 0;
+}
+
+int is_var_read(List *block, List *var_names, AstNode *excluded) {
+    int i, j;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+        if (node == excluded)
+            continue;
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                if (expression_reads_any(&node->data.variable_declaration.value->data.expression, var_names))
+                    return 1;
+                break;
+            case AST_ASSIGNMENT:
+                if (expression_reads_any(&node->data.assignment.expression->data.expression, var_names))
+                    return 1;
+                break;
+            case AST_SWAP_STATEMENT:
+                if (name_set_contains(var_names, node->data.swap_statement.var_a->value) ||
+                    name_set_contains(var_names, node->data.swap_statement.var_b->value))
+                    return 1;
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++) {
+                    if (expression_reads_any(
+                            &((AstNode *) node->data.function_call.args->items[j])->data.expression, var_names))
+                        return 1;
+                }
+                break;
+            case AST_IF_STATEMENT:
+                if (expression_reads_any(&node->data.if_statement.condition->data.expression, var_names) ||
+                    is_var_read(node->data.if_statement.body_node, var_names, excluded) ||
+                    is_var_read(node->data.if_statement.else_node, var_names, excluded))
+                    return 1;
+                break;
+            case AST_LOOP:
+                if ((node->data.loop.start && expression_reads_any(node->data.loop.start, var_names)) ||
+                    expression_reads_any(node->data.loop.end, var_names) ||
+                    is_var_read(node->data.loop.body, var_names, excluded))
+                    return 1;
+                break;
+            case AST_WHILE_LOOP:
+                if (expression_reads_any(&node->data.while_loop.condition->data.expression, var_names) ||
+                    is_var_read(node->data.while_loop.body, var_names, excluded))
+                    return 1;
+                break;
+            case AST_RETURN_STATEMENT:
+                if (expression_reads_any(&node->data.return_statement.value_expr->data.expression, var_names))
+                    return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+void push_operator_token(List *tokens, char *op, Token *original_tok) {
+    list_push(tokens, init_arithmetic_token_with(OPERATOR, (ArithmeticTokenValue) {.op = op}, original_tok));
+}
+
+void push_number_token(List *tokens, double number, Token *original_tok) {
+    list_push(tokens, init_arithmetic_token_with(NUMBER, (ArithmeticTokenValue) {.number = number}, original_tok));
+}
+
+void push_subtree_tokens(List *tokens, ExpressionNode *node) {
+    if (!node)
+        return;
+    push_subtree_tokens(tokens, node->left);
+    push_subtree_tokens(tokens, node->right);
+    list_push(tokens, init_arithmetic_token_with(node->token->type, node->token->value, node->token->original_tok));
+}
+
+void push_range_tokens(List *tokens, Expression *expr, Token *original_tok) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables) {
+        push_number_token(tokens, (int) expr->value->value.double_value, original_tok);
+        return;
+    }
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        list_push(tokens, init_arithmetic_token_with(token->type, token->value, token->original_tok));
+    }
+}
+
+void push_direction_tokens(List *tokens, Loop *loop, Token *original_tok) {
+    // (end > start) - (start > end)
+    push_range_tokens(tokens, loop->end, original_tok);
+    push_range_tokens(tokens, loop->start, original_tok);
+    push_operator_token(tokens, OP_GRATER_THAN, original_tok);
+    push_range_tokens(tokens, loop->start, original_tok);
+    push_range_tokens(tokens, loop->end, original_tok);
+    push_operator_token(tokens, OP_GRATER_THAN, original_tok);
+    push_operator_token(tokens, OP_SUB, original_tok);
+}
+
+void push_iteration_count_tokens(List *tokens, Loop *loop, Token *original_tok) {
+    if (!loop->loop_counter_name) {
+        // loop n times: n * (n > 0)
+        push_range_tokens(tokens, loop->end, original_tok);
+        push_range_tokens(tokens, loop->end, original_tok);
+        push_number_token(tokens, 0, original_tok);
+        push_operator_token(tokens, OP_GRATER_THAN, original_tok);
+        push_operator_token(tokens, OP_MUL, original_tok);
+        return;
+    }
+    // loop i: start to end times: (end - start) * direction
+    push_range_tokens(tokens, loop->end, original_tok);
+    push_range_tokens(tokens, loop->start, original_tok);
+    push_operator_token(tokens, OP_SUB, original_tok);
+    push_direction_tokens(tokens, loop, original_tok);
+    push_operator_token(tokens, OP_MUL, original_tok);
+}
+
+// pushes the sum of the values of the counter of a loop whose range is known only at runtime:
+// count * start + direction * count * (count - 1) / 2, where the last product is computed as
+// (count / 2) * (count - 1 + count % 2), so it is exact (modulo 2^32) and divides only non-negative numbers
+void push_counter_sum_tokens(List *tokens, Loop *loop, Token *original_tok) {
+    push_iteration_count_tokens(tokens, loop, original_tok);
+    push_range_tokens(tokens, loop->start, original_tok);
+    push_operator_token(tokens, OP_MUL, original_tok);
+
+    push_direction_tokens(tokens, loop, original_tok);
+
+    push_iteration_count_tokens(tokens, loop, original_tok);
+    push_number_token(tokens, 2, original_tok);
+    push_operator_token(tokens, OP_DIV, original_tok);
+    push_iteration_count_tokens(tokens, loop, original_tok);
+    push_number_token(tokens, 1, original_tok);
+    push_operator_token(tokens, OP_SUB, original_tok);
+    push_iteration_count_tokens(tokens, loop, original_tok);
+    push_number_token(tokens, 2, original_tok);
+    push_operator_token(tokens, OP_MOD, original_tok);
+    push_operator_token(tokens, OP_ADD, original_tok);
+    push_operator_token(tokens, OP_MUL, original_tok);
+
+    push_operator_token(tokens, OP_MUL, original_tok);
+    push_operator_token(tokens, OP_ADD, original_tok);
+}
+
+// sum of counter^0, counter^1 and counter^2 over the values of the counter from `low` to `high`, as the generated code
+// would compute them (modulo 2^32)
+void get_power_sums(long long low, long long high, int power_sums[SCEV_MAX_DEGREE + 1]) {
+    long long sum_1 = high * (high + 1) / 2 - (low - 1) * low / 2;
+    long long sum_2 = high * (high + 1) * (2 * high + 1) / 6 - (low - 1) * low * (2 * low - 1) / 6;
+
+    power_sums[0] = (int) (unsigned int) (high - low + 1);
+    power_sums[1] = (int) (unsigned int) sum_1;
+    power_sums[2] = (int) (unsigned int) sum_2;
+}
+
+AstNode *init_assignment(char *var_name, Token *position, List *tokens) {
+    AstNode *node = init_ast(AST_ASSIGNMENT);
+    AstNode *expression = init_ast(AST_EXPRESSION);
+
+    node->data.assignment.dst_variable = init_token(var_name, ID, position->line, position->column,
+                                                    (int) strlen(var_name));
+    list_dispose(expression->data.expression.tokens);
+    expression->data.expression.tokens = tokens;
+    expression->data.expression.value = init_literal_value(TYPE_INT, (Value) {});
+    expression->data.expression.contains_variables = 1;
+    node->data.assignment.expression = expression;
+    return node;
+}
+
+// returns the closed form of an accumulation: var + sign * count(degree) * coefficient + ...
+AstNode *get_closed_form(Loop *loop, AstNode *assignment, List *terms, int constant_range,
+                         int power_sums[SCEV_MAX_DEGREE + 1]) {
+    int i;
+    RecurrenceTerm *term;
+    Token *position = assignment->data.assignment.dst_variable;
+    List *tokens = init_list(sizeof(ArithmeticToken *));
+
+    list_push(tokens, init_arithmetic_token_with(VAR, (ArithmeticTokenValue) {.var = position->value}, position));
+    for (i = 0; i < terms->size; i++) {
+        term = terms->items[i];
+        if (constant_range)
+            push_number_token(tokens, power_sums[term->degree], position);
+        else if (term->degree == 1)
+            push_counter_sum_tokens(tokens, loop, position);
+        else
+            push_iteration_count_tokens(tokens, loop, position);
+        if (term->coefficient) {
+            push_subtree_tokens(tokens, term->coefficient);
+            push_operator_token(tokens, OP_MUL, position);
+        }
+        push_operator_token(tokens, term->sign == 1 ? OP_ADD : OP_SUB, position);
+    }
+    return init_assignment(position->value, position, tokens);
+}
+
+void dispose_recurrences(List *trees, List *terms) {
+    int i;
+    for (i = 0; i < trees->size; i++) {
+        expression_tree_dispose(trees->items[i]);
+        list_dispose(terms->items[i]);
+    }
+    free(trees->items);
+    free(trees);
+    free(terms->items);
+    free(terms);
+}
+
+// replaces the loop at `index` with the closed forms of its accumulations, if its body is made of accumulations only
+int replace_loop_with_closed_form(Optimizer *optimizer, List *block, int index, AstNode *function) {
+    int i, j, success = 1, constant_range, power_sums[SCEV_MAX_DEGREE + 1];
+    long long start = 0, end = 0;
+    char *var_name, *report, *previous_report;
+    AstNode *node = block->items[index], *statement, *closed_form;
+    Loop *loop = &node->data.loop;
+    Symbol *symbol;
+    List *written_vars = init_list(sizeof(char *)), *trees = init_list(sizeof(ExpressionNode *));
+    List *assignments = init_list(sizeof(AstNode *)), *all_terms = init_list(sizeof(List *)), *terms, *counter;
+    RecurrenceTerm *term;
+    Token *position;
+
+    // the body may only assign int variables, each one once
+    if (loop->loop_counter_name)
+        name_set_add(written_vars, loop->loop_counter_name);
+    for (i = 0; i < loop->body->size && success; i++) {
+        statement = loop->body->items[i];
+        if (statement->type == AST_NOOP)
+            continue;
+        if (statement->type != AST_ASSIGNMENT) {
+            success = 0;
+            break;
+        }
+        var_name = statement->data.assignment.dst_variable->value;
+        symbol = symbol_table_lookup(optimizer->symbol_table, var_name);
+        success = !name_set_contains(written_vars, var_name) && symbol && symbol->type == VARIABLE &&
+                  symbol->value.var_symbol.type == TYPE_INT &&
+                  statement->data.assignment.expression->data.expression.contains_variables;
+        name_set_add(written_vars, var_name);
+        list_push(assignments, statement);
+    }
+    success = success && assignments->size > 0 && !expression_reads_any(loop->end, written_vars) &&
+              (!loop->loop_counter_name || !expression_reads_any(loop->start, written_vars));
+
+    constant_range = !loop->end->contains_variables && (!loop->loop_counter_name || !loop->start->contains_variables);
+    if (success && constant_range) {
+        end = (long long) loop->end->value->value.double_value;
+        if (loop->loop_counter_name)
+            start = (long long) loop->start->value->value.double_value;
+        if (!loop->loop_counter_name)
+            get_power_sums(1, end, power_sums); // only the count is used
+        else if (start <= end)
+            get_power_sums(start, end - 1, power_sums);
+        else
+            get_power_sums(end + 1, start, power_sums);
+    }
+
+    for (i = 0; i < assignments->size && success; i++) {
+        statement = assignments->items[i];
+        list_push(trees, expression_tree_from_postfix(
+                statement->data.assignment.expression->data.expression.tokens, optimizer->lexer));
+        list_push(all_terms, terms = init_list(sizeof(RecurrenceTerm *)));
+        success = get_recurrence_terms(list_get_last(trees), statement->data.assignment.dst_variable->value,
+                                       loop->loop_counter_name, written_vars, terms);
+        // the sum of the squares of the counter is computed only for constant ranges
+        for (j = 0; j < terms->size && success; j++) {
+            term = terms->items[j];
+            if (constant_range)
+                success = term->degree == 0 ||
+                          (llabs(start) <= SCEV_MAX_CONSTANT_RANGE && llabs(end) <= SCEV_MAX_CONSTANT_RANGE);
+            else
+                success = term->degree <= 1;
+        }
+    }
+
+    if (success) {
+        list_remove(block, index);
+        for (i = 0; i < assignments->size; i++) {
+            closed_form = get_closed_form(loop, assignments->items[i], all_terms->items[i], constant_range,
+                                          power_sums);
+            index < block->size ? list_insert(block, index, closed_form) : list_push(block, closed_form);
+            index++;
+        }
+        // after the loop the counter is equal to the end of the range, if anyone reads it
+        position = ((AstNode *) assignments->items[0])->data.assignment.dst_variable;
+        if (loop->loop_counter_name) {
+            counter = init_list(sizeof(char *));
+            name_set_add(counter, loop->loop_counter_name);
+            if (optimizer_is_global_var(optimizer, loop->loop_counter_name) ||
+                is_var_read(function->data.function_definition.body, counter, node)) {
+                terms = init_list(sizeof(ArithmeticToken *));
+                push_range_tokens(terms, loop->end, position);
+                closed_form = init_assignment(loop->loop_counter_name, position, terms);
+                index < block->size ? list_insert(block, index, closed_form) : list_push(block, closed_form);
+            }
+            name_set_dispose(counter);
+        }
+
+        report = strdup(position->value);
+        for (i = 1; i < assignments->size; i++) {
+            previous_report = report;
+            alsprintf(&report, "%s, %s", previous_report,
+                      ((AstNode *) assignments->items[i])->data.assignment.dst_variable->value);
+            free(previous_report);
+        }
+        log_verbose(OPTIMIZER, "Scalar evolution: the loop at line %d in %s() was replaced by the closed form of %s",
+                    position->line, function->data.function_definition.func_name, report);
+        free(report);
+        ast_dispose(node);
+        optimizer->closed_form_loop_count++;
+    }
+
+    dispose_recurrences(trees, all_terms);
+    name_set_dispose(written_vars);
+    free(assignments->items);
+    free(assignments);
+    return success;
+}
+
+void replace_loops_with_closed_forms(Optimizer *optimizer, List *block, AstNode *function) {
+    int i;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_IF_STATEMENT:
+                replace_loops_with_closed_forms(optimizer, node->data.if_statement.body_node, function);
+                replace_loops_with_closed_forms(optimizer, node->data.if_statement.else_node, function);
+                break;
+            case AST_LOOP:
+                // inner loops first
+                replace_loops_with_closed_forms(optimizer, node->data.loop.body, function);
+                replace_loop_with_closed_form(optimizer, block, i, function);
+                break;
+            case AST_WHILE_LOOP:
+                replace_loops_with_closed_forms(optimizer, node->data.while_loop.body, function);
+                break;
+            default:
+                break;
+        }
+    }
+}
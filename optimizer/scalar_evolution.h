@@ -0,0 +1,98 @@
+#ifndef INFINITY_COMPILER_SCALAR_EVOLUTION_H
+#define INFINITY_COMPILER_SCALAR_EVOLUTION_H
+
+#include "optimizer.h"
+#include "../expression_evaluator/expression_tree.h"
+
+// the sums of the powers of the loop counter are computed at compile time for constant ranges within this bound,
+// where they fit in 64 bits
+#define SCEV_MAX_CONSTANT_RANGE (1 << 20)
+#define SCEV_MAX_DEGREE 2
+
+/**
+\RecurrenceTerm
+ A term of the change of a variable in every iteration of a loop: sign * coefficient * counter^degree.
+ The coefficient is loop-invariant.
+*/
+typedef struct RecurrenceTerm {
+    int degree; // power of the loop counter (0 - the term doesn't depend on the counter)
+    int sign; // 1 or -1
+    ExpressionNode *coefficient; // NULL for the coefficient 1
+} RecurrenceTerm;
+
+/// Splits the value assigned to a variable in a loop into `var + term + term ...`, where every term is a polynomial of
+/// the loop counter with loop-invariant coefficients (an affine or polynomial recurrence).
+/// \param root Tree of the assigned expression
+/// \param var_name The assigned variable
+/// \param counter_name Loop counter, NULL for loops without a counter
+/// \param written_vars Names of the variables the loop changes
+/// \param terms Output list of RecurrenceTerm
+/// \return If the assignment is a recurrence
+int get_recurrence_terms(ExpressionNode *root, char *var_name, char *counter_name, List *written_vars, List *terms);
+
+/// Splits an expression into a sum of terms, where every term is a loop-invariant coefficient times a power of
+/// the loop counter.
+/// \param root Tree of the expression
+/// \param counter_name Loop counter
+/// \param written_vars Names of the variables the loop changes, including the counter
+/// \param terms Output list of RecurrenceTerm
+/// \return If the expression is a polynomial of the loop counter
+int get_polynomial_terms(ExpressionNode *root, char *counter_name, List *written_vars, List *terms);
+
+/// Whether a subtree is loop-invariant and can be evaluated before the loop, even when the loop doesn't run
+/// (it has no division, modulus, power or factorial that may stop the program)
+/// \param node
+/// \param written_vars Names of the variables the loop changes
+/// \return Boolean
+int is_invariant_subtree(ExpressionNode *node, List *written_vars);
+
+/// Whether a block reads one of a set of variables
+/// \param block List of statements
+/// \param var_names Set of variable names
+/// \param excluded A statement in the block that is not checked, or NULL
+/// \return Boolean
+int is_var_read(List *block, List *var_names, AstNode *excluded);
+
+void push_operator_token(List *tokens, char *op, Token *original_tok);
+
+void push_number_token(List *tokens, double number, Token *original_tok);
+
+/// Pushes copies of the tokens of an expression tree, in postfix
+/// \param tokens
+/// \param node
+void push_subtree_tokens(List *tokens, ExpressionNode *node);
+
+/// Pushes copies of the tokens of a loop range expression (start or end)
+/// \param tokens
+/// \param expr
+/// \param original_tok Position of the pushed number, if the expression is constant
+void push_range_tokens(List *tokens, Expression *expr, Token *original_tok);
+
+/// Pushes the direction of a counted loop whose range is known only at runtime: 1, -1 (or 0 when it doesn't run)
+/// \param tokens
+/// \param loop
+/// \param original_tok Position of the pushed tokens
+void push_direction_tokens(List *tokens, Loop *loop, Token *original_tok);
+
+/// Pushes the number of iterations of a loop whose range is known only at runtime
+/// \param tokens
+/// \param loop
+/// \param original_tok Position of the pushed tokens
+void push_iteration_count_tokens(List *tokens, Loop *loop, Token *original_tok);
+
+/// Creates an assignment of an int expression
+/// \param var_name Assigned variable
+/// \param position Token for the position of the assignment
+/// \param tokens The assigned expression, in postfix
+/// \return AST_ASSIGNMENT node
+AstNode *init_assignment(char *var_name, Token *position, List *tokens);
+
+/// Replaces loops whose body only accumulates polynomials of the loop counter into variables
+/// (like `sum = sum + i` or `x = x + k`) with the closed forms of the accumulations.
+/// Inner loops are replaced first, so a loop of such loops can be replaced as well.
+/// \param optimizer
+/// \param block List of statements
+/// \param function Definition of the function the block belongs to, for the verbose report
+void replace_loops_with_closed_forms(Optimizer *optimizer, List *block, AstNode *function);
+
+#endif //INFINITY_COMPILER_SCALAR_EVOLUTION_H
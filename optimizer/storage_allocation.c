@@ -0,0 +1,395 @@
+#include "storage_allocation.h"
+#include "store_elimination.h"
+#include "../logging/logging.h"
+#include "../config/globals.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define SHARED_SLOTS_TABLE_SIZE 31
+
+void collect_referenced_vars(List *set, List *block) {
+    int i, j;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                name_set_add(set, node->data.variable_declaration.var->name);
+                add_expression_uses(set, &node->data.variable_declaration.value->data.expression);
+                break;
+            case AST_ASSIGNMENT:
+                name_set_add(set, node->data.assignment.dst_variable->value);
+                add_expression_uses(set, &node->data.assignment.expression->data.expression);
+                break;
+            case AST_SWAP_STATEMENT:
+                name_set_add(set, node->data.swap_statement.var_a->value);
+                name_set_add(set, node->data.swap_statement.var_b->value);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++)
+                    add_expression_uses(set, &((AstNode *) node->data.function_call.args->items[j])->data.expression);
+                break;
+            case AST_RETURN_STATEMENT:
+                add_expression_uses(set, &node->data.return_statement.value_expr->data.expression);
+                break;
+            case AST_IF_STATEMENT:
+                add_expression_uses(set, &node->data.if_statement.condition->data.expression);
+                collect_referenced_vars(set, node->data.if_statement.body_node);
+                collect_referenced_vars(set, node->data.if_statement.else_node);
+                break;
+            case AST_LOOP:
+                if (node->data.loop.loop_counter_name) {
+                    name_set_add(set, node->data.loop.loop_counter_name);
+                    add_expression_uses(set, node->data.loop.start);
+                }
+                add_expression_uses(set, node->data.loop.end);
+                collect_referenced_vars(set, node->data.loop.body);
+                break;
+            case AST_WHILE_LOOP:
+                add_expression_uses(set, &node->data.while_loop.condition->data.expression);
+                collect_referenced_vars(set, node->data.while_loop.body);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void collect_read_vars(List *set, List *block) {
+    int i, j;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                add_expression_uses(set, &node->data.variable_declaration.value->data.expression);
+                break;
+            case AST_ASSIGNMENT:
+                add_expression_uses(set, &node->data.assignment.expression->data.expression);
+                break;
+            case AST_SWAP_STATEMENT:
+                name_set_add(set, node->data.swap_statement.var_a->value);
+                name_set_add(set, node->data.swap_statement.var_b->value);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++)
+                    add_expression_uses(set, &((AstNode *) node->data.function_call.args->items[j])->data.expression);
+                break;
+            case AST_RETURN_STATEMENT:
+                add_expression_uses(set, &node->data.return_statement.value_expr->data.expression);
+                break;
+            case AST_IF_STATEMENT:
+                add_expression_uses(set, &node->data.if_statement.condition->data.expression);
+                collect_read_vars(set, node->data.if_statement.body_node);
+                collect_read_vars(set, node->data.if_statement.else_node);
+                break;
+            case AST_LOOP:
+                // the loop reads its counter to advance it
+                if (node->data.loop.loop_counter_name) {
+                    name_set_add(set, node->data.loop.loop_counter_name);
+                    add_expression_uses(set, node->data.loop.start);
+                }
+                add_expression_uses(set, node->data.loop.end);
+                collect_read_vars(set, node->data.loop.body);
+                break;
+            case AST_WHILE_LOOP:
+                add_expression_uses(set, &node->data.while_loop.condition->data.expression);
+                collect_read_vars(set, node->data.while_loop.body);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void update_loop_depth(Optimizer *optimizer, char *var_name, int depth) {
+    Symbol *symbol = symbol_table_lookup(optimizer->symbol_table, var_name);
+    symbol->value.var_symbol.loop_depth = MAX(symbol->value.var_symbol.loop_depth, depth);
+}
+
+void update_expression_loop_depth(Optimizer *optimizer, Expression *expr, int depth) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables)
+        return;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == VAR)
+            update_loop_depth(optimizer, token->value.var, depth);
+    }
+}
+
+void record_loop_depths(Optimizer *optimizer, List *block, int depth) {
+    int i, j;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                update_loop_depth(optimizer, node->data.variable_declaration.var->name, depth);
+                update_expression_loop_depth(optimizer, &node->data.variable_declaration.value->data.expression,
+                                             depth);
+                break;
+            case AST_ASSIGNMENT:
+                update_loop_depth(optimizer, node->data.assignment.dst_variable->value, depth);
+                update_expression_loop_depth(optimizer, &node->data.assignment.expression->data.expression, depth);
+                break;
+            case AST_SWAP_STATEMENT:
+                update_loop_depth(optimizer, node->data.swap_statement.var_a->value, depth);
+                update_loop_depth(optimizer, node->data.swap_statement.var_b->value, depth);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++)
+                    update_expression_loop_depth(optimizer, &((AstNode *) node->data.function_call.args->items[j])
+                            ->data.expression, depth);
+                break;
+            case AST_RETURN_STATEMENT:
+                update_expression_loop_depth(optimizer, &node->data.return_statement.value_expr->data.expression,
+                                             depth);
+                break;
+            case AST_IF_STATEMENT:
+                update_expression_loop_depth(optimizer, &node->data.if_statement.condition->data.expression, depth);
+                record_loop_depths(optimizer, node->data.if_statement.body_node, depth);
+                record_loop_depths(optimizer, node->data.if_statement.else_node, depth);
+                break;
+            case AST_LOOP:
+                // the range is evaluated once, the counter is advanced on every iteration
+                if (node->data.loop.loop_counter_name) {
+                    update_loop_depth(optimizer, node->data.loop.loop_counter_name, depth + 1);
+                    update_expression_loop_depth(optimizer, node->data.loop.start, depth);
+                }
+                update_expression_loop_depth(optimizer, node->data.loop.end, depth);
+                record_loop_depths(optimizer, node->data.loop.body, depth + 1);
+                break;
+            case AST_WHILE_LOOP:
+                update_expression_loop_depth(optimizer, &node->data.while_loop.condition->data.expression, depth + 1);
+                record_loop_depths(optimizer, node->data.while_loop.body, depth + 1);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+VariableInterval *get_variable_interval(List *intervals, char *var_name) {
+    int i;
+    VariableInterval *interval;
+
+    for (i = 0; i < intervals->size; i++) {
+        interval = intervals->items[i];
+        if (strcmp(interval->var_name, var_name) == 0)
+            return interval;
+    }
+    interval = malloc(sizeof(VariableInterval));
+    if (!interval)
+        throw_memory_allocation_error(OPTIMIZER);
+    interval->var_name = var_name;
+    interval->first = INT_MAX;
+    interval->last = -1;
+    interval->declaration = -1;
+    list_push(intervals, interval);
+    return interval;
+}
+
+void add_variable_reference(List *intervals, char *var_name, int number) {
+    VariableInterval *interval = get_variable_interval(intervals, var_name);
+    interval->first = MIN(interval->first, number);
+    interval->last = MAX(interval->last, number);
+}
+
+void add_expression_references(List *intervals, Expression *expr, int number) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables)
+        return;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == VAR)
+            add_variable_reference(intervals, token->value.var, number);
+    }
+}
+
+// extends to the whole loop the intervals of the variables that are referenced in it and declared outside of it
+void extend_loop_intervals(List *intervals, int first, int last) {
+    int i;
+    VariableInterval *interval;
+
+    for (i = 0; i < intervals->size; i++) {
+        interval = intervals->items[i];
+        if (interval->first > last || interval->last < first ||
+            (interval->declaration > first && interval->declaration <= last))
+            continue;
+        interval->first = MIN(interval->first, first);
+        interval->last = MAX(interval->last, last);
+    }
+}
+
+void record_variable_intervals(List *intervals, List *block, int *number) {
+    int i, j, at;
+    AstNode *node;
+    VariableInterval *interval;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+        at = (*number)++;
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                interval = get_variable_interval(intervals, node->data.variable_declaration.var->name);
+                interval->declaration = interval->declaration == -1 ? at : MULTIPLE_DECLARATIONS;
+                add_variable_reference(intervals, node->data.variable_declaration.var->name, at);
+                add_expression_references(intervals, &node->data.variable_declaration.value->data.expression, at);
+                break;
+            case AST_ASSIGNMENT:
+                add_variable_reference(intervals, node->data.assignment.dst_variable->value, at);
+                add_expression_references(intervals, &node->data.assignment.expression->data.expression, at);
+                break;
+            case AST_SWAP_STATEMENT:
+                add_variable_reference(intervals, node->data.swap_statement.var_a->value, at);
+                add_variable_reference(intervals, node->data.swap_statement.var_b->value, at);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++)
+                    add_expression_references(intervals, &((AstNode *) node->data.function_call.args->items[j])
+                            ->data.expression, at);
+                break;
+            case AST_RETURN_STATEMENT:
+                add_expression_references(intervals, &node->data.return_statement.value_expr->data.expression, at);
+                break;
+            case AST_IF_STATEMENT:
+                add_expression_references(intervals, &node->data.if_statement.condition->data.expression, at);
+                record_variable_intervals(intervals, node->data.if_statement.body_node, number);
+                record_variable_intervals(intervals, node->data.if_statement.else_node, number);
+                break;
+            case AST_LOOP:
+                if (node->data.loop.loop_counter_name) {
+                    add_variable_reference(intervals, node->data.loop.loop_counter_name, at);
+                    add_expression_references(intervals, node->data.loop.start, at);
+                }
+                add_expression_references(intervals, node->data.loop.end, at);
+                record_variable_intervals(intervals, node->data.loop.body, number);
+                extend_loop_intervals(intervals, at, *number - 1);
+                break;
+            case AST_WHILE_LOOP:
+                add_expression_references(intervals, &node->data.while_loop.condition->data.expression, at);
+                record_variable_intervals(intervals, node->data.while_loop.body, number);
+                extend_loop_intervals(intervals, at, *number - 1);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int share_stack_slots(Optimizer *optimizer, AstNode *node, Symbol *function) {
+    int i, j, statement_count = 0, shared_count = 0;
+    char *var_name;
+    Symbol *symbol;
+    VariableInterval *interval, *owner;
+    List *intervals = init_list(sizeof(VariableInterval *));
+    List *candidates = init_list(sizeof(VariableInterval *));
+    List *owners = init_list(sizeof(VariableInterval *));
+    List *args = node->data.function_definition.args;
+
+    record_variable_intervals(intervals, node->data.function_definition.body, &statement_count);
+    // the local variables of the frame, in the order of their first reference
+    for (i = 0; i < intervals->size; i++) {
+        interval = intervals->items[i];
+        symbol = symbol_table_lookup(optimizer->symbol_table, interval->var_name);
+        if (symbol->value.var_symbol.global || !name_set_contains(function->value.func_symbol.vars, interval->var_name))
+            continue;
+        for (j = 0; j < args->size && strcmp(((Variable *) args->items[j])->name, interval->var_name) != 0; j++);
+        if (j < args->size)
+            continue;
+        if (interval->declaration < 0) {
+            interval->first = 0;
+            interval->last = statement_count;
+        }
+        list_push(candidates, interval);
+        for (j = candidates->size - 1; j > 0 && interval->first < ((VariableInterval *) candidates->items[j - 1])
+                ->first; j--)
+            candidates->items[j] = candidates->items[j - 1];
+        candidates->items[j] = interval;
+    }
+
+    function->value.func_symbol.shared_slots = init_hash_table(SHARED_SLOTS_TABLE_SIZE, NULL);
+    for (i = 0; i < candidates->size; i++) {
+        interval = candidates->items[i];
+        symbol = symbol_table_lookup(optimizer->symbol_table, interval->var_name);
+        // owners keep the end of the last interval in their slot
+        for (j = 0; j < owners->size; j++) {
+            owner = owners->items[j];
+            if (owner->last < interval->first && symbol_table_lookup(optimizer->symbol_table, owner->var_name)
+                    ->value.var_symbol.var_size == symbol->value.var_symbol.var_size)
+                break;
+        }
+        if (j == owners->size) {
+            list_push(owners, interval);
+            continue;
+        }
+        owner->last = interval->last;
+        hash_table_insert(function->value.func_symbol.shared_slots, var_name = strdup(interval->var_name),
+                          owner->var_name);
+        log_verbose(OPTIMIZER, "Storage sharing: '%s' shares the stack slot of '%s' in %s()", var_name,
+                    owner->var_name, node->data.function_definition.func_name);
+        shared_count++;
+    }
+
+    list_dispose(intervals);
+    free(candidates->items);
+    free(candidates);
+    free(owners->items);
+    free(owners);
+    return shared_count;
+}
+
+void allocate_variable_storage(Optimizer *optimizer) {
+    int i, unused_count = 0, shared_count = 0;
+    AstNode *node;
+    Symbol *symbol;
+    List *read = init_list(sizeof(char *));
+    List *var_symbols = optimizer->symbol_table->var_symbols;
+
+    // collect the variables read by every reachable function, and by the initializers of the global variables
+    for (i = 0; i < optimizer->root->data.compound.children->size; i++) {
+        node = optimizer->root->data.compound.children->items[i];
+        if (node->type == AST_VARIABLE_DECLARATION) {
+            add_expression_uses(read, &node->data.variable_declaration.value->data.expression);
+            continue;
+        }
+        if (node->type != AST_FUNCTION_DEFINITION)
+            continue;
+        symbol = symbol_table_lookup(optimizer->symbol_table, node->data.function_definition.func_name);
+        if (!symbol->value.func_symbol.reachable)
+            continue;
+
+        // arguments and local variables that are never read get no stack slot
+        symbol->value.func_symbol.vars = init_list(sizeof(char *));
+        collect_read_vars(symbol->value.func_symbol.vars, node->data.function_definition.body);
+        record_loop_depths(optimizer, node->data.function_definition.body, 0);
+        name_set_add_all(read, symbol->value.func_symbol.vars);
+        shared_count += share_stack_slots(optimizer, node, symbol);
+    }
+
+    for (i = 0; i < var_symbols->size; i++) {
+        symbol = var_symbols->items[i];
+        symbol->value.var_symbol.unused = !name_set_contains(read, symbol->value.var_symbol.var_name);
+        unused_count += symbol->value.var_symbol.unused;
+    }
+    log_verbose(OPTIMIZER, "Unused variable elimination: %d variable%s removed", unused_count,
+                unused_count == 1 ? "" : "s");
+    log_verbose(OPTIMIZER, "Storage sharing: %d local variable%s the stack slot of another one", shared_count,
+                shared_count == 1 ? " shares" : "s share");
+
+    name_set_dispose(read);
+}
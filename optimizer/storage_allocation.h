@@ -0,0 +1,62 @@
+#ifndef INFINITY_COMPILER_STORAGE_ALLOCATION_H
+#define INFINITY_COMPILER_STORAGE_ALLOCATION_H
+
+#include "optimizer.h"
+
+// a variable that is declared more than once in a function
+#define MULTIPLE_DECLARATIONS (-2)
+
+/**
+\VariableInterval
+ The statements of a function between the first and the last reference to a variable, numbered in program order.
+ Outside of it, the variable holds no value that is used, so its stack slot can be shared.
+*/
+typedef struct VariableInterval {
+    char *var_name;
+    int first; // number of the first statement that references the variable
+    int last; // number of the last statement that references the variable
+    int declaration; // number of the statement that declares the variable, -1 if none
+} VariableInterval;
+
+/// Adds the names of the variables referenced (read or written) in a block to a set
+/// \param set
+/// \param block List of statements
+void collect_referenced_vars(List *set, List *block);
+
+/// Adds the names of the variables read in a block to a set.
+/// The variables that are only written are not added: their values are never used.
+/// \param set
+/// \param block List of statements
+void collect_read_vars(List *set, List *block);
+
+/// Records in the variable symbols the deepest loop nesting level where they are referenced in a block
+/// \param optimizer
+/// \param block List of statements
+/// \param depth Loop nesting level of the block
+void record_loop_depths(Optimizer *optimizer, List *block, int depth);
+
+/// Numbers the statements of a block in program order, and records the statements that reference every variable.
+/// A variable that is referenced in a loop and declared outside of it is live in the whole loop, since its value
+/// is carried to the next iteration.
+/// \param intervals List of the intervals of the variables
+/// \param block List of statements
+/// \param number Number of the next statement
+void record_variable_intervals(List *intervals, List *block, int *number);
+
+/// Lets the local variables of a function share stack slots: in the order of their first reference, a variable takes
+/// the slot of a variable of the same size whose interval (and the intervals of the others that share it) ended.
+/// Arguments, and variables that are not declared in the function, are live in the whole function.
+/// \param optimizer
+/// \param node Function definition
+/// \param function Function symbol, whose variables are recorded
+/// \return The number of variables that got the slot of another variable
+int share_stack_slots(Optimizer *optimizer, AstNode *node, Symbol *function);
+
+/// Decides the storage of the variables: records in every reachable function the variables it reads,
+/// which get a slot in its stack frame. Variables that are never read get no storage, and their stores are dropped.
+/// Local variables whose intervals don't overlap share a slot.
+/// Also records the loop depth of the variables, for the data layout.
+/// \param optimizer
+void allocate_variable_storage(Optimizer *optimizer);
+
+#endif //INFINITY_COMPILER_STORAGE_ALLOCATION_H
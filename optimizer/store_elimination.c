@@ -0,0 +1,349 @@
+#include "store_elimination.h"
+#include "../config/table_initializers.h"
+#include "../logging/logging.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Variable name sets */
+int name_set_contains(List *set, char *name) {
+    int i;
+    for (i = 0; i < set->size; i++) {
+        if (strcmp(set->items[i], name) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+void name_set_add(List *set, char *name) {
+    if (!name_set_contains(set, name))
+        list_push(set, name);
+}
+
+void name_set_remove(List *set, char *name) {
+    int i;
+    for (i = 0; i < set->size; i++) {
+        if (strcmp(set->items[i], name) == 0) {
+            list_remove(set, i);
+            return;
+        }
+    }
+}
+
+void name_set_add_all(List *set, List *other) {
+    int i;
+    for (i = 0; i < other->size; i++)
+        name_set_add(set, other->items[i]);
+}
+
+List *name_set_copy(List *set) {
+    List *copy = init_list(sizeof(char *));
+    name_set_add_all(copy, set);
+    return copy;
+}
+
+int name_set_equals(List *set_a, List *set_b) {
+    int i;
+    if (set_a->size != set_b->size)
+        return 0;
+    for (i = 0; i < set_a->size; i++) {
+        if (!name_set_contains(set_b, set_a->items[i]))
+            return 0;
+    }
+    return 1;
+}
+
+void name_set_dispose(List *set) {
+    // the names are owned by the AST
+    free(set->items);
+    free(set);
+}
+
+void add_expression_uses(List *set, Expression *expr) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables)
+        return;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == VAR)
+            name_set_add(set, token->value.var);
+    }
+}
+
+// whether evaluating the expression can stop the program (zero division)
+int expression_may_trap(Expression *expr) {
+    int i;
+    ArithmeticToken *token;
+
+    if (!expr->contains_variables)
+        return 0;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type == OPERATOR && (strcmp(token->value.op, OP_DIV) == 0 || strcmp(token->value.op, OP_MOD) == 0))
+            return 1;
+    }
+    return 0;
+}
+
+/** Copy propagation */
+typedef struct Copy {
+    char *dst;
+    char *src;
+} Copy;
+
+void kill_copies(List *copies, char *var_name) {
+    int i;
+    Copy *copy;
+    for (i = copies->size - 1; i >= 0; i--) {
+        copy = copies->items[i];
+        if (strcmp(copy->dst, var_name) == 0 || strcmp(copy->src, var_name) == 0)
+            free(list_remove(copies, i));
+    }
+}
+
+void replace_copied_vars(Optimizer *optimizer, List *copies, Expression *expr) {
+    int i, j;
+    ArithmeticToken *token;
+    Copy *copy;
+
+    if (!expr->contains_variables)
+        return;
+    for (i = 0; i < expr->tokens->size; i++) {
+        token = expr->tokens->items[i];
+        if (token->type != VAR)
+            continue;
+        for (j = 0; j < copies->size; j++) {
+            copy = copies->items[j];
+            if (strcmp(copy->dst, token->value.var) == 0) {
+                token->value.var = copy->src;
+                optimizer->propagated_copy_count++;
+                break;
+            }
+        }
+    }
+}
+
+// records `dst = src` if the expression is a plain copy of another variable of the same type
+void record_copy(Optimizer *optimizer, List *copies, char *dst, Expression *expr) {
+    ArithmeticToken *token;
+    Copy *copy;
+
+    kill_copies(copies, dst);
+    if (!expr->contains_variables || expr->tokens->size != 1)
+        return;
+    token = expr->tokens->items[0];
+    if (token->type != VAR || strcmp(token->value.var, dst) == 0 ||
+        symbol_table_lookup(optimizer->symbol_table, token->value.var)->value.var_symbol.type !=
+        symbol_table_lookup(optimizer->symbol_table, dst)->value.var_symbol.type)
+        return;
+
+    copy = malloc(sizeof(Copy));
+    if (!copy)
+        throw_memory_allocation_error(OPTIMIZER);
+    copy->dst = dst;
+    copy->src = token->value.var;
+    list_push(copies, copy);
+}
+
+void propagate_copies(Optimizer *optimizer, List *block) {
+    int i, j;
+    AstNode *node;
+    Expression *arg_expr;
+    List *copies = init_list(sizeof(Copy *));
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                replace_copied_vars(optimizer, copies, &node->data.variable_declaration.value->data.expression);
+                record_copy(optimizer, copies, node->data.variable_declaration.var->name,
+                            &node->data.variable_declaration.value->data.expression);
+                break;
+            case AST_ASSIGNMENT:
+                replace_copied_vars(optimizer, copies, &node->data.assignment.expression->data.expression);
+                record_copy(optimizer, copies, node->data.assignment.dst_variable->value,
+                            &node->data.assignment.expression->data.expression);
+                break;
+            case AST_SWAP_STATEMENT:
+                kill_copies(copies, node->data.swap_statement.var_a->value);
+                kill_copies(copies, node->data.swap_statement.var_b->value);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++) {
+                    arg_expr = &((AstNode *) node->data.function_call.args->items[j])->data.expression;
+                    // a single variable is printed according to its name (see generate_print), so keep it
+                    if (arg_expr->contains_variables && arg_expr->tokens->size == 1 &&
+                        hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name))
+                        continue;
+                    replace_copied_vars(optimizer, copies, arg_expr);
+                }
+                // the function may change any global variable
+                if (!hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name))
+                    list_clear(copies, 1);
+                break;
+            case AST_RETURN_STATEMENT:
+                replace_copied_vars(optimizer, copies, &node->data.return_statement.value_expr->data.expression);
+                break;
+            case AST_IF_STATEMENT:
+                replace_copied_vars(optimizer, copies, &node->data.if_statement.condition->data.expression);
+                list_clear(copies, 1);
+                propagate_copies(optimizer, node->data.if_statement.body_node);
+                propagate_copies(optimizer, node->data.if_statement.else_node);
+                break;
+            case AST_LOOP:
+                // the range is evaluated once, before the loop
+                replace_copied_vars(optimizer, copies, node->data.loop.end);
+                if (node->data.loop.loop_counter_name)
+                    replace_copied_vars(optimizer, copies, node->data.loop.start);
+                list_clear(copies, 1);
+                propagate_copies(optimizer, node->data.loop.body);
+                break;
+            case AST_WHILE_LOOP:
+                list_clear(copies, 1);
+                propagate_copies(optimizer, node->data.while_loop.body);
+                break;
+            default:
+                list_clear(copies, 1);
+                break;
+        }
+    }
+    list_dispose(copies);
+}
+
+/** Liveness */
+// liveness at the head of a loop: iterates over the body until the live set doesn't change
+List *analyze_loop_liveness(Optimizer *optimizer, List *body, List *head_uses, List *live_out,
+                            int remove_dead_stores) {
+    List *head, *body_in, *new_head;
+
+    head = name_set_copy(live_out);
+    name_set_add_all(head, head_uses);
+    while (1) {
+        body_in = analyze_liveness(optimizer, body, head, 0);
+        new_head = name_set_copy(live_out);
+        name_set_add_all(new_head, head_uses);
+        name_set_add_all(new_head, body_in);
+        name_set_dispose(body_in);
+        if (name_set_equals(new_head, head)) {
+            name_set_dispose(new_head);
+            break;
+        }
+        name_set_dispose(head);
+        head = new_head;
+    }
+    if (remove_dead_stores)
+        name_set_dispose(analyze_liveness(optimizer, body, head, 1));
+
+    return head;
+}
+
+// whether the store to `var_name` can be removed, when it is followed by the `live` variables
+int is_dead_store(Optimizer *optimizer, List *live, char *var_name, Expression *value) {
+    return !name_set_contains(live, var_name) && !optimizer_is_global_var(optimizer, var_name) &&
+           !expression_may_trap(value);
+}
+
+List *analyze_liveness(Optimizer *optimizer, List *block, List *live_out, int remove_dead_stores) {
+    int i, j;
+    AstNode *node;
+    Expression *value;
+    char *dst, *var_a, *var_b;
+    List *live, *then_live, *else_live, *head_uses;
+
+    live = name_set_copy(live_out);
+    for (i = (int) block->size - 1; i >= 0; i--) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+            case AST_ASSIGNMENT:
+                if (node->type == AST_VARIABLE_DECLARATION) {
+                    dst = node->data.variable_declaration.var->name;
+                    value = &node->data.variable_declaration.value->data.expression;
+                } else {
+                    dst = node->data.assignment.dst_variable->value;
+                    value = &node->data.assignment.expression->data.expression;
+                }
+                if (remove_dead_stores && is_dead_store(optimizer, live, dst, value)) {
+                    ast_dispose(list_remove(block, i));
+                    optimizer->dead_store_count++;
+                    break;
+                }
+                name_set_remove(live, dst);
+                add_expression_uses(live, value);
+                break;
+            case AST_SWAP_STATEMENT:
+                var_a = node->data.swap_statement.var_a->value;
+                var_b = node->data.swap_statement.var_b->value;
+                if (remove_dead_stores && !name_set_contains(live, var_a) && !name_set_contains(live, var_b) &&
+                    !optimizer_is_global_var(optimizer, var_a) && !optimizer_is_global_var(optimizer, var_b)) {
+                    ast_dispose(list_remove(block, i));
+                    optimizer->dead_store_count++;
+                    break;
+                }
+                name_set_add(live, var_a);
+                name_set_add(live, var_b);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++)
+                    add_expression_uses(live, &((AstNode *) node->data.function_call.args->items[j])->data.expression);
+                // the function may read any global variable
+                if (!hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name))
+                    name_set_add_all(live, optimizer->global_vars);
+                break;
+            case AST_RETURN_STATEMENT:
+                // nothing after the return is executed
+                list_clear(live, 0);
+                name_set_add_all(live, optimizer->global_vars);
+                if (node->data.return_statement.value_expr->data.expression.value->type != TYPE_VOID)
+                    add_expression_uses(live, &node->data.return_statement.value_expr->data.expression);
+                break;
+            case AST_IF_STATEMENT:
+                then_live = analyze_liveness(optimizer, node->data.if_statement.body_node, live, remove_dead_stores);
+                else_live = analyze_liveness(optimizer, node->data.if_statement.else_node, live, remove_dead_stores);
+                name_set_add_all(then_live, else_live);
+                add_expression_uses(then_live, &node->data.if_statement.condition->data.expression);
+                name_set_dispose(else_live);
+                name_set_dispose(live);
+                live = then_live;
+                break;
+            case AST_WHILE_LOOP:
+                head_uses = init_list(sizeof(char *));
+                add_expression_uses(head_uses, &node->data.while_loop.condition->data.expression);
+                then_live = analyze_loop_liveness(optimizer, node->data.while_loop.body, head_uses, live,
+                                                  remove_dead_stores);
+                name_set_dispose(head_uses);
+                name_set_dispose(live);
+                live = then_live;
+                break;
+            case AST_LOOP:
+                // the loop counter is compared and advanced on every iteration
+                head_uses = init_list(sizeof(char *));
+                if (node->data.loop.loop_counter_name)
+                    name_set_add(head_uses, node->data.loop.loop_counter_name);
+                then_live = analyze_loop_liveness(optimizer, node->data.loop.body, head_uses, live,
+                                                  remove_dead_stores);
+                name_set_dispose(head_uses);
+                name_set_dispose(live);
+                live = then_live;
+                // the range is evaluated once, before the counter is initialized
+                if (node->data.loop.loop_counter_name) {
+                    name_set_remove(live, node->data.loop.loop_counter_name);
+                    add_expression_uses(live, node->data.loop.start);
+                }
+                add_expression_uses(live, node->data.loop.end);
+                break;
+            default:
+                break;
+        }
+    }
+    return live;
+}
+
+void eliminate_dead_stores(Optimizer *optimizer, AstNode *function) {
+    // local variables are dead when the function returns
+    name_set_dispose(analyze_liveness(optimizer, function->data.function_definition.body, optimizer->global_vars, 1));
+}
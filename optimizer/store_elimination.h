@@ -0,0 +1,44 @@
+#ifndef INFINITY_COMPILER_STORE_ELIMINATION_H
+#define INFINITY_COMPILER_STORE_ELIMINATION_H
+
+#include "optimizer.h"
+
+/** Variable name sets (lists of names, without duplicates) */
+int name_set_contains(List *set, char *name);
+
+void name_set_add(List *set, char *name);
+
+void name_set_remove(List *set, char *name);
+
+void name_set_add_all(List *set, List *other);
+
+List *name_set_copy(List *set);
+
+void name_set_dispose(List *set);
+
+/// Adds the names of the variables used in an expression to a set
+/// \param set
+/// \param expr
+void add_expression_uses(List *set, Expression *expr);
+
+/// Forward pass: replaces uses of a variable that holds a copy of another variable (`y = x`) with the
+/// original variable, as long as neither of them is changed. Copies don't live across control flow statements.
+/// \param optimizer
+/// \param block List of statements
+void propagate_copies(Optimizer *optimizer, List *block);
+
+/// Backward liveness pass over a block.
+/// \param optimizer
+/// \param block List of statements
+/// \param live_out Variables that are live after the block
+/// \param remove_dead_stores Whether to remove the stores to variables that are not live.
+/// Passes that only compute the liveness (like the iterations over a loop body) don't change the block.
+/// \return Set of the variables live before the block (allocated)
+List *analyze_liveness(Optimizer *optimizer, List *block, List *live_out, int remove_dead_stores);
+
+/// Removes the dead stores of a function, and the copies that became dead after propagating them.
+/// \param optimizer
+/// \param function Function definition node
+void eliminate_dead_stores(Optimizer *optimizer, AstNode *function);
+
+#endif //INFINITY_COMPILER_STORE_ELIMINATION_H
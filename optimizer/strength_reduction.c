@@ -0,0 +1,485 @@
+#include "strength_reduction.h"
+#include "scalar_evolution.h"
+#include "store_elimination.h"
+#include "interprocedural.h"
+#include "../config/table_initializers.h"
+#include "../expression_evaluator/expression_evaluator.h"
+#include "../logging/logging.h"
+#include "../io/io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+void collect_written_vars(Optimizer *optimizer, List *set, List *block) {
+    int i;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                name_set_add(set, node->data.variable_declaration.var->name);
+                break;
+            case AST_ASSIGNMENT:
+                name_set_add(set, node->data.assignment.dst_variable->value);
+                break;
+            case AST_SWAP_STATEMENT:
+                name_set_add(set, node->data.swap_statement.var_a->value);
+                name_set_add(set, node->data.swap_statement.var_b->value);
+                break;
+            case AST_FUNCTION_CALL:
+                if (!hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name))
+                    name_set_add_all(set, optimizer->global_vars);
+                break;
+            case AST_IF_STATEMENT:
+                collect_written_vars(optimizer, set, node->data.if_statement.body_node);
+                collect_written_vars(optimizer, set, node->data.if_statement.else_node);
+                break;
+            case AST_LOOP:
+                if (node->data.loop.loop_counter_name)
+                    name_set_add(set, node->data.loop.loop_counter_name);
+                collect_written_vars(optimizer, set, node->data.loop.body);
+                break;
+            case AST_WHILE_LOOP:
+                collect_written_vars(optimizer, set, node->data.while_loop.body);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int subtree_reads_var(ExpressionNode *node, char *var_name) {
+    if (!node)
+        return 0;
+    if (node->token->type == VAR)
+        return strcmp(node->token->value.var, var_name) == 0;
+    return subtree_reads_var(node->left, var_name) || subtree_reads_var(node->right, var_name);
+}
+
+int tokens_equal(List *a, List *b) {
+    int i;
+    ArithmeticToken *token_a, *token_b;
+
+    if (a->size != b->size)
+        return 0;
+    for (i = 0; i < a->size; i++) {
+        token_a = a->items[i];
+        token_b = b->items[i];
+        if (token_a->type != token_b->type)
+            return 0;
+        switch (token_a->type) {
+            case VAR:
+                if (strcmp(token_a->value.var, token_b->value.var) != 0)
+                    return 0;
+                break;
+            case NUMBER:
+                if (token_a->value.number != token_b->value.number)
+                    return 0;
+                break;
+            case OPERATOR:
+                if (strcmp(token_a->value.op, token_b->value.op) != 0)
+                    return 0;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+// whether a subtree is worth replacing with an induction variable: a polynomial of the counter that multiplies it
+int is_reducible_subtree(ExpressionNode *node, char *counter_name, List *written_vars) {
+    int i, reducible = 0;
+    RecurrenceTerm *term;
+    List *terms;
+
+    if (!subtree_reads_var(node, counter_name))
+        return 0;
+    terms = init_list(sizeof(RecurrenceTerm *));
+    if (get_polynomial_terms(node, counter_name, written_vars, terms)) {
+        for (i = 0; i < terms->size; i++) {
+            term = terms->items[i];
+            if (term->degree == 2 || (term->degree == 1 && term->coefficient))
+                reducible = 1;
+        }
+    }
+    list_dispose(terms);
+    return reducible;
+}
+
+InductionVariable *get_induction_variable(Optimizer *optimizer, List *induction_vars, ExpressionNode *node,
+                                          char *counter_name) {
+    int i;
+    InductionVariable *induction_var;
+    List *tokens = init_list(sizeof(ArithmeticToken *));
+
+    push_subtree_tokens(tokens, node);
+    for (i = 0; i < induction_vars->size; i++) {
+        induction_var = induction_vars->items[i];
+        if (tokens_equal(induction_var->tokens, tokens)) {
+            list_dispose(tokens);
+            return induction_var;
+        }
+    }
+
+    induction_var = malloc(sizeof(InductionVariable));
+    if (!induction_var)
+        throw_memory_allocation_error(OPTIMIZER);
+    alsprintf(&induction_var->name, INDUCTION_VARIABLE_NAME_FORMAT, counter_name,
+              ++optimizer->induction_variable_count);
+    induction_var->tokens = tokens;
+    induction_var->position = node->token->original_tok;
+    symbol_table_insert(optimizer->symbol_table, VARIABLE, induction_var->name,
+                        (SymbolValue) {.var_symbol = (VariableSymbol) {
+                                .var_name = induction_var->name,
+                                .type = TYPE_INT
+                        }}, NULL);
+    list_push(induction_vars, induction_var);
+    return induction_var;
+}
+
+// pushes the tokens of an expression tree, replacing its reducible subtrees with induction variables
+void push_reduced_tokens(Optimizer *optimizer, List *tokens, ExpressionNode *node, char *counter_name,
+                         List *written_vars, List *induction_vars) {
+    InductionVariable *induction_var;
+
+    if (!node)
+        return;
+    if (node->token->type == OPERATOR && is_reducible_subtree(node, counter_name, written_vars)) {
+        induction_var = get_induction_variable(optimizer, induction_vars, node, counter_name);
+        list_push(tokens, init_arithmetic_token_with(VAR, (ArithmeticTokenValue) {.var = induction_var->name},
+                                                     node->token->original_tok));
+        return;
+    }
+    push_reduced_tokens(optimizer, tokens, node->left, counter_name, written_vars, induction_vars);
+    push_reduced_tokens(optimizer, tokens, node->right, counter_name, written_vars, induction_vars);
+    list_push(tokens, init_arithmetic_token_with(node->token->type, node->token->value, node->token->original_tok));
+}
+
+void reduce_expression(Optimizer *optimizer, Expression *expr, char *counter_name, List *written_vars,
+                       List *induction_vars) {
+    ExpressionNode *root;
+    List *tokens;
+
+    if (!expr->contains_variables || expr->value->type == TYPE_STRING)
+        return;
+    root = expression_tree_from_postfix(expr->tokens, optimizer->lexer);
+    if (subtree_reads_var(root, counter_name)) {
+        tokens = init_list(sizeof(ArithmeticToken *));
+        push_reduced_tokens(optimizer, tokens, root, counter_name, written_vars, induction_vars);
+        list_dispose(expr->tokens);
+        expr->tokens = tokens;
+    }
+    expression_tree_dispose(root);
+}
+
+void reduce_block(Optimizer *optimizer, List *block, char *counter_name, List *written_vars, List *induction_vars) {
+    int i, j;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_VARIABLE_DECLARATION:
+                reduce_expression(optimizer, &node->data.variable_declaration.value->data.expression, counter_name,
+                                  written_vars, induction_vars);
+                break;
+            case AST_ASSIGNMENT:
+                reduce_expression(optimizer, &node->data.assignment.expression->data.expression, counter_name,
+                                  written_vars, induction_vars);
+                break;
+            case AST_FUNCTION_CALL:
+                for (j = 0; j < node->data.function_call.args->size; j++)
+                    reduce_expression(optimizer,
+                                      &((AstNode *) node->data.function_call.args->items[j])->data.expression,
+                                      counter_name, written_vars, induction_vars);
+                break;
+            case AST_RETURN_STATEMENT:
+                reduce_expression(optimizer, &node->data.return_statement.value_expr->data.expression, counter_name,
+                                  written_vars, induction_vars);
+                break;
+            case AST_IF_STATEMENT:
+                reduce_expression(optimizer, &node->data.if_statement.condition->data.expression, counter_name,
+                                  written_vars, induction_vars);
+                reduce_block(optimizer, node->data.if_statement.body_node, counter_name, written_vars,
+                             induction_vars);
+                reduce_block(optimizer, node->data.if_statement.else_node, counter_name, written_vars,
+                             induction_vars);
+                break;
+            case AST_LOOP:
+                if (node->data.loop.loop_counter_name)
+                    reduce_expression(optimizer, node->data.loop.start, counter_name, written_vars, induction_vars);
+                reduce_expression(optimizer, node->data.loop.end, counter_name, written_vars, induction_vars);
+                reduce_block(optimizer, node->data.loop.body, counter_name, written_vars, induction_vars);
+                break;
+            case AST_WHILE_LOOP:
+                reduce_expression(optimizer, &node->data.while_loop.condition->data.expression, counter_name,
+                                  written_vars, induction_vars);
+                reduce_block(optimizer, node->data.while_loop.body, counter_name, written_vars, induction_vars);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// pushes the tokens of an expression tree, with the loop counter replaced by the start of the loop range
+void push_tokens_at_start(List *tokens, ExpressionNode *node, Loop *loop) {
+    if (!node)
+        return;
+    if (node->token->type == VAR && strcmp(node->token->value.var, loop->loop_counter_name) == 0) {
+        push_range_tokens(tokens, loop->start, node->token->original_tok);
+        return;
+    }
+    push_tokens_at_start(tokens, node->left, loop);
+    push_tokens_at_start(tokens, node->right, loop);
+    list_push(tokens, init_arithmetic_token_with(node->token->type, node->token->value, node->token->original_tok));
+}
+
+void push_loop_direction_tokens(List *tokens, Loop *loop, Token *position) {
+    if (!loop->start->contains_variables && !loop->end->contains_variables)
+        push_number_token(tokens, loop->forward ? 1 : -1, position);
+    else
+        push_direction_tokens(tokens, loop, position);
+}
+
+// the change of the term in the first iteration: direction for i, 2 * direction * start + 1 for i * i
+void push_first_difference_tokens(List *tokens, RecurrenceTerm *term, Loop *loop, Token *position) {
+    push_loop_direction_tokens(tokens, loop, position);
+    if (term->degree == 2) {
+        push_number_token(tokens, 2, position);
+        push_operator_token(tokens, OP_MUL, position);
+        push_range_tokens(tokens, loop->start, position);
+        push_operator_token(tokens, OP_MUL, position);
+        push_number_token(tokens, 1, position);
+        push_operator_token(tokens, OP_ADD, position);
+    }
+}
+
+// the change of the change of the term in every iteration: 0 for i, 2 for i * i
+void push_second_difference_tokens(List *tokens, RecurrenceTerm *term, Token *position) {
+    push_number_token(tokens, term->degree == 2 ? 2 : 0, position);
+}
+
+// pushes: sum of sign * coefficient * difference(term) over the terms of a polynomial that depend on the counter,
+// where the difference is the first or the second difference of counter^degree between two iterations
+void push_differences_tokens(List *tokens, List *terms, int second, Loop *loop, Token *position) {
+    int i;
+    RecurrenceTerm *term;
+
+    push_number_token(tokens, 0, position);
+    for (i = 0; i < terms->size; i++) {
+        term = terms->items[i];
+        if (term->degree == 0)
+            continue;
+        if (second)
+            push_second_difference_tokens(tokens, term, position);
+        else
+            push_first_difference_tokens(tokens, term, loop, position);
+        if (term->coefficient) {
+            push_subtree_tokens(tokens, term->coefficient);
+            push_operator_token(tokens, OP_MUL, position);
+        }
+        push_operator_token(tokens, term->sign == 1 ? OP_ADD : OP_SUB, position);
+    }
+}
+
+// returns an assignment of an expression, evaluated at compile time when it only has numbers
+AstNode *init_folded_assignment(Optimizer *optimizer, char *var_name, Token *position, List *tokens) {
+    int i;
+    double value;
+    ArithmeticToken *token;
+    AstNode *node = init_assignment(var_name, position, tokens);
+
+    for (i = 0; i < tokens->size; i++) {
+        token = tokens->items[i];
+        if (token->type != NUMBER && token->type != OPERATOR)
+            return node;
+    }
+    value = evaluate_postfix(tokens, optimizer->lexer);
+    if (value >= INT_MIN && value <= INT_MAX) {
+        node->data.assignment.expression->data.expression.value->value.double_value = value;
+        node->data.assignment.expression->data.expression.contains_variables = 0;
+    }
+    return node;
+}
+
+// returns `var = var + step`. a step that is not constant is computed once, into a new variable before the loop
+AstNode *init_increment(Optimizer *optimizer, List *block, int *index, char *var_name, Token *position,
+                        List *step_tokens) {
+    char *step_name = alsprintf(&step_name, INDUCTION_STEP_NAME_FORMAT, var_name);
+    AstNode *step = init_folded_assignment(optimizer, step_name, position, step_tokens);
+    Expression *step_expr = &step->data.assignment.expression->data.expression;
+    List *tokens = init_list(sizeof(ArithmeticToken *));
+
+    list_push(tokens, init_arithmetic_token_with(VAR, (ArithmeticTokenValue) {.var = var_name}, position));
+    if (step_expr->contains_variables) {
+        symbol_table_insert(optimizer->symbol_table, VARIABLE, step_name,
+                            (SymbolValue) {.var_symbol = (VariableSymbol) {
+                                    .var_name = step_name,
+                                    .type = TYPE_INT
+                            }}, NULL);
+        list_insert(block, (*index)++, step);
+        list_push(tokens, init_arithmetic_token_with(VAR, (ArithmeticTokenValue) {.var = step_name}, position));
+    } else {
+        push_number_token(tokens, step_expr->value->value.double_value, position);
+        ast_dispose(step);
+        free(step_name);
+    }
+    push_operator_token(tokens, OP_ADD, position);
+    return init_assignment(var_name, position, tokens);
+}
+
+// initializes an induction variable before the loop at `index`, and updates it at the end of the loop body
+void maintain_induction_variable(Optimizer *optimizer, List *block, int *index, InductionVariable *induction_var,
+                                 List *written_vars) {
+    int i, has_square = 0;
+    char *difference_name, *counter_name;
+    Loop *loop = &((AstNode *) block->items[*index])->data.loop;
+    ExpressionNode *root = expression_tree_from_postfix(induction_var->tokens, optimizer->lexer);
+    Token *position = induction_var->position;
+    List *terms = init_list(sizeof(RecurrenceTerm *)), *tokens;
+    AstNode *difference_update = NULL;
+
+    counter_name = loop->loop_counter_name;
+    get_polynomial_terms(root, counter_name, written_vars, terms);
+    for (i = 0; i < terms->size; i++)
+        has_square |= ((RecurrenceTerm *) terms->items[i])->degree == 2;
+
+    tokens = init_list(sizeof(ArithmeticToken *));
+    push_tokens_at_start(tokens, root, loop);
+    list_insert(block, (*index)++, init_folded_assignment(optimizer, induction_var->name, position, tokens));
+
+    // the change of the variable between two iterations
+    tokens = init_list(sizeof(ArithmeticToken *));
+    push_differences_tokens(tokens, terms, 0, loop, position);
+    if (has_square) {
+        // the change itself changes linearly, so it is an induction variable too
+        alsprintf(&difference_name, INDUCTION_VARIABLE_NAME_FORMAT, counter_name,
+                  ++optimizer->induction_variable_count);
+        symbol_table_insert(optimizer->symbol_table, VARIABLE, difference_name,
+                            (SymbolValue) {.var_symbol = (VariableSymbol) {
+                                    .var_name = difference_name,
+                                    .type = TYPE_INT
+                            }}, NULL);
+        list_insert(block, (*index)++, init_folded_assignment(optimizer, difference_name, position, tokens));
+        tokens = init_list(sizeof(ArithmeticToken *));
+        push_differences_tokens(tokens, terms, 1, loop, position);
+        difference_update = init_increment(optimizer, block, index, difference_name, position, tokens);
+
+        tokens = init_list(sizeof(ArithmeticToken *));
+        list_push(tokens, init_arithmetic_token_with(VAR, (ArithmeticTokenValue) {.var = induction_var->name},
+                                                     position));
+        list_push(tokens, init_arithmetic_token_with(VAR, (ArithmeticTokenValue) {.var = difference_name},
+                                                     position));
+        push_operator_token(tokens, OP_ADD, position);
+        list_push(loop->body, init_assignment(induction_var->name, position, tokens));
+        list_push(loop->body, difference_update);
+    } else {
+        list_push(loop->body, init_increment(optimizer, block, index, induction_var->name, position, tokens));
+    }
+
+    list_dispose(terms);
+    expression_tree_dispose(root);
+}
+
+// turns a counted loop whose counter is not read into a loop without a counter
+int eliminate_loop_counter(Optimizer *optimizer, AstNode *node, AstNode *function) {
+    int count;
+    Loop *loop = &node->data.loop;
+    List *counter = init_list(sizeof(char *)), *tokens;
+    Token *position;
+
+    name_set_add(counter, loop->loop_counter_name);
+    if (is_var_read(loop->body, counter, NULL) ||
+        is_var_read(function->data.function_definition.body, counter, node)) {
+        name_set_dispose(counter);
+        return 0;
+    }
+    name_set_dispose(counter);
+
+    if (loop->start->contains_variables || loop->end->contains_variables) {
+        position = ((ArithmeticToken *) (loop->end->contains_variables ? loop->end : loop->start)->tokens->items[0])
+                ->original_tok;
+        tokens = init_list(sizeof(ArithmeticToken *));
+        push_iteration_count_tokens(tokens, loop, position);
+        list_dispose(loop->end->tokens);
+        loop->end->tokens = tokens;
+        loop->end->contains_variables = 1;
+    } else {
+        count = abs((int) loop->end->value->value.double_value - (int) loop->start->value->value.double_value);
+        // a loop without a counter runs at least once
+        if (count == 0)
+            return 0;
+        loop->end->value->value.double_value = count;
+    }
+    // the tokens of constant expressions may be shared with copies of the function
+    if (loop->start->contains_variables)
+        list_clear(loop->start->tokens, 1);
+    loop->start->contains_variables = 0;
+    loop->start->value->value.double_value = 0;
+    loop->loop_counter_name = NULL;
+    loop->forward = 1;
+    optimizer->eliminated_counter_count++;
+    return 1;
+}
+
+// reduces the loop at `index`, and returns its new index
+int reduce_loop(Optimizer *optimizer, List *block, int index, AstNode *function) {
+    int i;
+    AstNode *node = block->items[index];
+    Loop *loop = &node->data.loop;
+    List *written_vars, *induction_vars;
+    InductionVariable *induction_var;
+
+    // the counter of a global loop may be read by the called functions
+    if (!loop->loop_counter_name || optimizer_is_global_var(optimizer, loop->loop_counter_name) ||
+        is_var_written(loop->body, loop->loop_counter_name))
+        return index;
+
+    written_vars = init_list(sizeof(char *));
+    induction_vars = init_list(sizeof(InductionVariable *));
+    name_set_add(written_vars, loop->loop_counter_name);
+    collect_written_vars(optimizer, written_vars, loop->body);
+
+    reduce_block(optimizer, loop->body, loop->loop_counter_name, written_vars, induction_vars);
+    for (i = 0; i < induction_vars->size; i++) {
+        induction_var = induction_vars->items[i];
+        maintain_induction_variable(optimizer, block, &index, induction_var, written_vars);
+        list_dispose(induction_var->tokens);
+    }
+    eliminate_loop_counter(optimizer, node, function);
+
+    list_dispose(induction_vars);
+    name_set_dispose(written_vars);
+    return index;
+}
+
+void reduce_induction_variables(Optimizer *optimizer, List *block, AstNode *function) {
+    int i;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+
+        switch (node->type) {
+            case AST_IF_STATEMENT:
+                reduce_induction_variables(optimizer, node->data.if_statement.body_node, function);
+                reduce_induction_variables(optimizer, node->data.if_statement.else_node, function);
+                break;
+            case AST_LOOP:
+                // inner loops first
+                reduce_induction_variables(optimizer, node->data.loop.body, function);
+                i = reduce_loop(optimizer, block, i, function);
+                break;
+            case AST_WHILE_LOOP:
+                reduce_induction_variables(optimizer, node->data.while_loop.body, function);
+                break;
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef INFINITY_COMPILER_STRENGTH_REDUCTION_H
+#define INFINITY_COMPILER_STRENGTH_REDUCTION_H
+
+#include "optimizer.h"
+
+// names of the variables created for derived induction variables (<loop counter>.iv<index>) and their steps
+// (<induction variable>.step). they can't collide with the variables of the program, since identifiers have no dots
+#define INDUCTION_VARIABLE_NAME_FORMAT "%s.iv%d"
+#define INDUCTION_STEP_NAME_FORMAT "%s.step"
+
+/**
+\InductionVariable
+ A variable that holds the value of an expression of the loop counter (like `i * 4 + base` or `i * i`) in every
+ iteration of a counted loop. It is updated with an addition per iteration, instead of being computed from scratch.
+*/
+typedef struct InductionVariable {
+    char *name;
+    List *tokens; // the derived expression, in postfix
+    Token *position; // position of the expression in the code, for the created statements
+} InductionVariable;
+
+/// Adds the names of the variables a block may change to a set.
+/// A call to a function that isn't builtin may change any global variable.
+/// \param optimizer
+/// \param set
+/// \param block List of statements
+void collect_written_vars(Optimizer *optimizer, List *set, List *block);
+
+/// Induction-variable strength reduction: in counted loops, replaces the expressions that are polynomials of the
+/// loop counter (of degree 1 or 2, with loop-invariant coefficients) with derived induction variables, which are
+/// initialized before the loop and maintained with additions at the end of every iteration.
+/// When the counter is not used anymore, the loop is turned into a loop without a counter.
+/// Inner loops are reduced first.
+/// \param optimizer
+/// \param block List of statements
+/// \param function Definition of the function the block belongs to
+void reduce_induction_variables(Optimizer *optimizer, List *block, AstNode *function);
+
+#endif //INFINITY_COMPILER_STRENGTH_REDUCTION_H
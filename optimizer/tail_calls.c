@@ -0,0 +1,34 @@
+#include "tail_calls.h"
+#include "../config/table_initializers.h"
+
+// whether the statement is `return;`
+int is_void_return(AstNode *node) {
+    return node->type == AST_RETURN_STATEMENT &&
+           node->data.return_statement.value_expr->data.expression.value->type == TYPE_VOID;
+}
+
+void mark_tail_calls(Optimizer *optimizer, List *block, int is_tail) {
+    int i, is_tail_statement;
+    AstNode *node;
+
+    for (i = 0; i < block->size; i++) {
+        node = block->items[i];
+        is_tail_statement = i == block->size - 1 ? is_tail : is_void_return(block->items[i + 1]);
+
+        switch (node->type) {
+            case AST_FUNCTION_CALL:
+                if (is_tail_statement &&
+                    !hash_table_lookup(builtin_function_to_generator_map, node->data.function_call.func_name)) {
+                    node->data.function_call.is_tail_call = 1;
+                    optimizer->tail_call_count++;
+                }
+                break;
+            case AST_IF_STATEMENT:
+                mark_tail_calls(optimizer, node->data.if_statement.body_node, is_tail_statement);
+                mark_tail_calls(optimizer, node->data.if_statement.else_node, is_tail_statement);
+                break;
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef INFINITY_COMPILER_TAIL_CALLS_H
+#define INFINITY_COMPILER_TAIL_CALLS_H
+
+#include "optimizer.h"
+
+/// Marks the calls to user functions that are in tail position: the calling function returns right after them,
+/// either by a `return;` statement or by reaching the end of its body.
+/// Calls inside loops are never in tail position.
+/// \param optimizer
+/// \param block List of statements
+/// \param is_tail If the function returns right after the block
+void mark_tail_calls(Optimizer *optimizer, List *block, int is_tail);
+
+#endif //INFINITY_COMPILER_TAIL_CALLS_H
@@ -0,0 +1,81 @@
+#include "options_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+CompilerOptions compiler_options = {
+        .verbose = 0,
+        .hot_data_first = 0,
+        .align_functions = DEFAULT_FUNCTION_ALIGNMENT,
+        .align_loops = DEFAULT_LOOP_ALIGNMENT,
+        .partial_evaluation = 0,
+        .buffered_output = 1,
+        .runtime_path = NULL,
+};
+
+#define ALIGN_FUNCTIONS_OPTION "-falign-functions="
+#define ALIGN_LOOPS_OPTION "-falign-loops="
+#define RUNTIME_OPTION "-fruntime="
+
+int parse_options(int argc, char *argv[]) {
+    int i, positional_count = 1;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            // positional argument - keep it
+            argv[positional_count++] = argv[i];
+            continue;
+        }
+
+        if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            compiler_options.verbose = 1;
+        } else if (strcmp(argv[i], "-fhot-data-first") == 0) {
+            compiler_options.hot_data_first = 1;
+        } else if (strcmp(argv[i], "-fpartial-evaluation") == 0) {
+            compiler_options.partial_evaluation = 1;
+        } else if (strcmp(argv[i], "-fno-buffered-output") == 0) {
+            compiler_options.buffered_output = 0;
+        } else if (strncmp(argv[i], RUNTIME_OPTION, strlen(RUNTIME_OPTION)) == 0) {
+            compiler_options.runtime_path = argv[i] + strlen(RUNTIME_OPTION);
+        } else if (strncmp(argv[i], ALIGN_FUNCTIONS_OPTION, strlen(ALIGN_FUNCTIONS_OPTION)) == 0) {
+            compiler_options.align_functions = parse_alignment_option(argv[i],
+                                                                      argv[i] + strlen(ALIGN_FUNCTIONS_OPTION));
+        } else if (strncmp(argv[i], ALIGN_LOOPS_OPTION, strlen(ALIGN_LOOPS_OPTION)) == 0) {
+            compiler_options.align_loops = parse_alignment_option(argv[i], argv[i] + strlen(ALIGN_LOOPS_OPTION));
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_options_usage();
+            exit(1);
+        }
+    }
+    argv[positional_count] = NULL;
+
+    return positional_count;
+}
+
+int parse_alignment_option(char *option, char *value) {
+    char *end;
+    long alignment = strtol(value, &end, 10);
+
+    if (*value == '\0' || *end != '\0' || alignment < 1 || alignment > 64 || (alignment & (alignment - 1)) != 0) {
+        fprintf(stderr, "Invalid alignment: %s (expected a power of 2 between 1 and 64)\n", option);
+        print_options_usage();
+        exit(1);
+    }
+    return (int) alignment;
+}
+
+void print_options_usage() {
+    printf("Options:\n"
+           "  -v, --verbose\t\tReport the optimizations applied to the program\n"
+           "  -fhot-data-first\tLay out the variables used in the most nested loops first\n"
+           "  -falign-functions=N\tAlign function entries to N bytes (default: %d, 1 to disable)\n"
+           "  -falign-loops=N\tAlign loop heads to N bytes (default: %d, 1 to disable)\n"
+           "  -fpartial-evaluation\tRun the program at compile time, and output a program that only writes its "
+           "output\n"
+           "  -fno-buffered-output\tWrite the output of every print right away, instead of collecting it in a "
+           "buffer\n"
+           "  -fruntime=PATH\tUse the helper procedures in PATH instead of the built-in ones (for developing "
+           "them)\n",
+           DEFAULT_FUNCTION_ALIGNMENT, DEFAULT_LOOP_ALIGNMENT);
+}
@@ -0,0 +1,42 @@
+#ifndef INFINITY_COMPILER_OPTIONS_PARSER_H
+#define INFINITY_COMPILER_OPTIONS_PARSER_H
+
+/**
+\CompilerOptions
+ Options given to the compiler from the command line.
+*/
+typedef struct CompilerOptions {
+    int verbose; // -v, --verbose: report what the optimizations did
+    int hot_data_first; // -fhot-data-first: lay out the variables used in deep loops first in the .bss segment
+    int align_functions; // -falign-functions=N: alignment of function entries, in bytes (1 - no alignment)
+    int align_loops; // -falign-loops=N: alignment of loop heads (the targets of the back edges), in bytes
+    int partial_evaluation; // -fpartial-evaluation: run the program at compile time, and emit only its output
+    int buffered_output; // collect the output in a buffer, and write it in big chunks (-fno-buffered-output: off)
+    char *runtime_path; // -fruntime=PATH: file of helper procedures to use instead of the embedded include.asm
+} CompilerOptions;
+
+// fetch blocks of modern x86 processors are 16 bytes long
+#define DEFAULT_FUNCTION_ALIGNMENT 16
+#define DEFAULT_LOOP_ALIGNMENT 16
+
+extern CompilerOptions compiler_options;
+
+/// Parses the command line options (arguments starting with '-') into `compiler_options`.
+/// The options are removed from `argv`, so only the positional arguments are left in it.
+/// Exits with a usage message on an unknown option.
+/// \param argc
+/// \param argv
+/// \return The number of arguments left in `argv` (including the program name)
+int parse_options(int argc, char *argv[]);
+
+/// Parses the value of an alignment option (like `-falign-loops=N`). Exits with a usage message if it is not a power
+/// of 2 between 1 and 64.
+/// \param option The whole option, for the error message
+/// \param value The text after the '='
+/// \return The alignment in bytes
+int parse_alignment_option(char *option, char *value);
+
+/// Prints the supported options
+void print_options_usage();
+
+#endif //INFINITY_COMPILER_OPTIONS_PARSER_H
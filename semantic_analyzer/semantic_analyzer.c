@@ -122,9 +122,57 @@ int semantic_analyze_tree(SemanticAnalyzer *analyzer) {
     // pop the scope containing the builtin functions
     scope_stack_pop_scope(analyzer->scope_stack);
 
+    if (analyzer->starting_point) {
+        semantic_mark_reachable_functions(analyzer, starting_point_entry);
+        semantic_report_unreachable_functions(analyzer);
+        semantic_decide_calling_conventions(analyzer);
+    }
+
     return analyzer->error_count;
 }
 
+void semantic_mark_reachable_functions(SemanticAnalyzer *analyzer, Symbol *function) {
+    int i;
+    if (function->value.func_symbol.reachable)
+        return;
+    function->value.func_symbol.reachable = 1;
+    for (i = 0; i < function->value.func_symbol.callees->size; i++)
+        semantic_mark_reachable_functions(analyzer, function->value.func_symbol.callees->items[i]);
+}
+
+void semantic_report_unreachable_functions(SemanticAnalyzer *analyzer) {
+    int i;
+    AstNode *node;
+    List *children = analyzer->root->data.compound.children;
+
+    for (i = 0; i < children->size; i++) {
+        node = children->items[i];
+        if (node->type == AST_FUNCTION_DEFINITION &&
+            !symbol_table_lookup(analyzer->table,
+                                 node->data.function_definition.func_name)->value.func_symbol.reachable) {
+            log_verbose(SEMANTIC_ANALYZER, "Dead function elimination: '%s' is never called from '%s'",
+                        node->data.function_definition.func_name, analyzer->root_func_name);
+        }
+    }
+}
+
+void semantic_decide_calling_conventions(SemanticAnalyzer *analyzer) {
+    int i;
+    AstNode *node;
+    Symbol *symbol;
+    List *children = analyzer->root->data.compound.children;
+
+    for (i = 0; i < children->size; i++) {
+        node = children->items[i];
+        if (node->type != AST_FUNCTION_DEFINITION)
+            continue;
+        symbol = symbol_table_lookup(analyzer->table, node->data.function_definition.func_name);
+        // the starting point is called by the entry code, with the arguments on the stack
+        symbol->value.func_symbol.fastcall = node != analyzer->starting_point &&
+                                             node->data.function_definition.args->size > 0;
+    }
+}
+
 /** Analyzes a block.
  * Adds a new scope to the scope stack, and pops it at the end
  * */
@@ -150,7 +198,12 @@ void semantic_analyze_block(SemanticAnalyzer *analyzer, List *block, AstNode *pa
                                     (SymbolValue) {.func_symbol = (FunctionSymbol) {
                                             .func_name = curr_node->data.function_definition.func_name,
                                             .arg_types = curr_node->data.function_definition.args,
-                                            .returned = 0
+                                            .returned = 0,
+                                            .callees = init_list(sizeof(Symbol *)),
+                                            .reachable = 0,
+                                            .vars = NULL,
+                                            .shared_slots = NULL,
+                                            .fastcall = 0
                                     }},
                                     curr_node);
                 scope_stack_add_identifier(analyzer->scope_stack,
@@ -284,6 +337,7 @@ void semantic_analyze_variable_declaration(SemanticAnalyzer *analyzer, AstNode *
                             (SymbolValue) {.var_symbol = (VariableSymbol) {
                                     .var_name = node->data.variable_declaration.var->name,
                                     .type = node->data.variable_declaration.var->value->type,
+                                    .global = parent == analyzer->root
                             }},
                             node);
         scope_stack_add_identifier(analyzer->scope_stack, strdup(node->data.variable_declaration.var->name));
@@ -453,6 +507,7 @@ void semantic_analyze_return_statement(SemanticAnalyzer *analyzer, AstNode *node
 
 void semantic_analyze_function_call(SemanticAnalyzer *analyzer, AstNode *node, AstNode *parent) {
     int i;
+    List *callees;
     Symbol *target_func = symbol_table_lookup(analyzer->table, node->data.function_call.func_name);
 
     // check if function exists
@@ -468,6 +523,16 @@ void semantic_analyze_function_call(SemanticAnalyzer *analyzer, AstNode *node, A
         analyzer->error_count += 1;
     }
 
+    // add the call to the call graph
+    if (target_func->type == FUNCTION && target_func->value.func_symbol.callees &&
+        parent->type == AST_FUNCTION_DEFINITION) {
+        callees = symbol_table_lookup(analyzer->table,
+                                      parent->data.function_definition.func_name)->value.func_symbol.callees;
+        for (i = 0; i < callees->size && callees->items[i] != target_func; i++);
+        if (i == callees->size)
+            list_push(callees, target_func);
+    }
+
     // check that the count of the arguments is matching with the target function
     // -1 is for builtin functions that takes unlimited amount of arguments
     if (target_func->value.func_symbol.arg_types->size != -1) {
@@ -50,6 +50,22 @@ void semantic_add_builtin_functions_to_scope(SemanticAnalyzer *analyzer);
 /// \return The number of semantic errors found.
 int semantic_analyze_tree(SemanticAnalyzer *analyzer);
 
+/// Marks a function, and every function it calls (directly or not), as reachable.
+/// Uses the call graph built while analyzing the function calls.
+/// \param analyzer
+/// \param function Function symbol
+void semantic_mark_reachable_functions(SemanticAnalyzer *analyzer, Symbol *function);
+
+/// Reports (in verbose mode) the functions that are not reachable from the starting point.
+/// Those functions are not generated.
+/// \param analyzer
+void semantic_report_unreachable_functions(SemanticAnalyzer *analyzer);
+
+/// Decides the calling convention of every function: functions called only by other functions
+/// pass their first arguments in registers (fastcall), and the starting point takes all of them on the stack.
+/// \param analyzer
+void semantic_decide_calling_conventions(SemanticAnalyzer *analyzer);
+
 /// Analyzes a block of code (between curly braces)
 /// \param analyzer
 /// \param block List of expressions inside the block
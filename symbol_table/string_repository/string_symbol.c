@@ -13,6 +13,7 @@ StringSymbol *init_string_symbol(char *id) {
     s_symbol->value = id;
     s_symbol->symbol_name = generate_string_symbol_id();
     s_symbol->length = strlen(id);
+    s_symbol->used = 0;
 
     return s_symbol;
 }
@@ -7,6 +7,7 @@ typedef struct StringSymbol {
     char *symbol_name; // formatted symbol name, as will appear in the data segment
     char *value; // value of the string
     size_t length;
+    int used; // if the generated code refers to the string
 } StringSymbol;
 
 StringSymbol *init_string_symbol(char *id);
@@ -36,5 +36,18 @@ int compare_function_signatures(FunctionSymbol *func1, FunctionSymbol *func2) {
 }
 
 void symbol_dispose(void *entry) {
-    free((Symbol *) entry);
+    Symbol *symbol = (Symbol *) entry;
+    // the callees are owned by the symbol table
+    if (symbol->type == FUNCTION && symbol->value.func_symbol.callees) {
+        free(symbol->value.func_symbol.callees->items);
+        free(symbol->value.func_symbol.callees);
+    }
+    // the variable names are owned by the AST
+    if (symbol->type == FUNCTION && symbol->value.func_symbol.vars) {
+        free(symbol->value.func_symbol.vars->items);
+        free(symbol->value.func_symbol.vars);
+    }
+    if (symbol->type == FUNCTION && symbol->value.func_symbol.shared_slots)
+        hash_table_dispose(symbol->value.func_symbol.shared_slots);
+    free(symbol);
 }
@@ -4,6 +4,7 @@
 #include "../../types/types.h"
 #include "../../variable/variable.h"
 #include "../../ast/ast.h"
+#include "../../hash_table/hash_table.h"
 
 typedef enum {
     BYTE,
@@ -14,12 +15,22 @@ typedef struct {
     char *func_name;
     List *arg_types;
     int returned; // if a return statement was met
+    List *callees; // symbols of the functions called from this function (the call graph). NULL for builtin functions
+    int reachable; // if the function can be called from the starting point
+    List *vars; // names of the variables read by the function, which are stored in its frame (set by the optimizer)
+    HashTable *shared_slots; // local variable name -> name of the variable whose stack slot it shares (set by the
+                             // optimizer)
+    int fastcall; // if the first arguments are passed in registers (see FASTCALL_ARG_REGISTERS)
 } FunctionSymbol;
 
 typedef struct {
     char *var_name;
     DataType type;
     VarSize var_size;
+    int global; // if the variable is declared outside of functions. global variables are stored in the .bss segment,
+                // other variables in the stack frame of their function
+    int loop_depth; // deepest loop nesting level where the variable is referenced
+    int unused; // if the variable is never read, so no storage is reserved for it
 } VariableSymbol;
 
 typedef enum {
@@ -0,0 +1,71 @@
+#!/bin/bash
+# Runs the test programs: every program is compiled, assembled with NASM and linked with ld as a Linux 32-bit
+# executable, and its output is compared with the output written in its header comment:
+#
+#   // <what the program checks>
+#   // Options: <compiler options>     (optional)
+#   // Exit code: <exit status>        (optional, 0 by default)
+#   // Expected output:
+#   // <first line of the output>
+#   // ...
+#
+# println ends a line with a carriage return (new_line_chr), which is compared as a line break.
+#
+# Usage: tests/run_tests.sh <compiler> [programs...]
+# Without programs, runs all the programs in the tests directory.
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <compiler> [programs...]"
+    exit 2
+fi
+
+tests_dir=$(cd "$(dirname "$0")" && pwd)
+compiler=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+shift
+if [ $# -gt 0 ]; then
+    programs=("$@")
+else
+    programs=("$tests_dir"/*.inf)
+fi
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+failed=0
+
+for program in "${programs[@]}"; do
+    program=$(cd "$(dirname "$program")" && pwd)/$(basename "$program")
+    name=$(basename "$program" .inf)
+    options=$(sed -n 's|^// Options: ||p' "$program")
+    expected_status=$(sed -n 's|^// Exit code: ||p' "$program")
+    expected_output=$(sed -n '/^\/\/ Expected output:/,/^[^\/]/{/^\/\//p}' "$program" | tail -n +2 | sed 's|^// \?||')
+
+    # paths in the options are relative to the tests directory
+    if ! (cd "$tests_dir" && "$compiler" $options "$program" "$work_dir/$name.asm") > "$work_dir/$name.log" 2>&1; then
+        echo "FAIL $name: compilation failed"
+        cat "$work_dir/$name.log"
+        failed=$((failed + 1))
+        continue
+    fi
+    if ! nasm -f elf32 "$work_dir/$name.asm" -o "$work_dir/$name.o" ||
+       ! ld -m elf_i386 "$work_dir/$name.o" -o "$work_dir/$name"; then
+        echo "FAIL $name: assembly failed"
+        failed=$((failed + 1))
+        continue
+    fi
+    output=$(timeout 10 "$work_dir/$name" | tr '\r' '\n'; exit "${PIPESTATUS[0]}")
+    status=$?
+
+    if [ "$output" != "$expected_output" ] || [ "$status" != "${expected_status:-0}" ]; then
+        echo "FAIL $name"
+        if [ "$status" != "${expected_status:-0}" ]; then
+            echo "exit code $status, expected ${expected_status:-0}"
+        fi
+        diff <(echo "$expected_output") <(echo "$output") | head -20
+        failed=$((failed + 1))
+    else
+        echo "ok   $name"
+    fi
+done
+
+echo "$((${#programs[@]} - failed)) of ${#programs[@]} tests passed"
+[ $failed -eq 0 ]